@@ -8,8 +8,7 @@ using namespace std;
 
 ByteStream::ByteStream( uint64_t capacity )
   : capacity_( capacity )
-  , buffer()
-  , buffer_actual()
+  , chunks()
   , closed( false )
   , hasError( false )
   , bytesPopped( 0 )
@@ -17,18 +16,55 @@ ByteStream::ByteStream( uint64_t capacity )
   , bytesBuffered( 0 )
 {}
 
+ByteStream::Chunks::Chunks( const Chunks& other ) : buffer(), buffer_actual( other.buffer_actual )
+{
+  const size_t first = buffer_actual.size() - other.buffer.size();
+  for ( size_t i = 0; i < other.buffer.size(); i++ ) {
+    const size_t offset = other.buffer[i].data() - other.buffer_actual[first + i].data();
+    buffer.push_back( string_view( buffer_actual[first + i] ).substr( offset, other.buffer[i].size() ) );
+  }
+}
+
+ByteStream::ByteStream( const ByteStream& other )
+  : capacity_( other.capacity_ )
+  , chunks( other.chunks ? make_unique<Chunks>( *other.chunks ) : nullptr )
+  , closed( other.closed )
+  , hasError( other.hasError )
+  , bytesPopped( other.bytesPopped )
+  , bytesPushed( other.bytesPushed )
+  , bytesBuffered( other.bytesBuffered )
+{}
+
+ByteStream& ByteStream::operator=( const ByteStream& other )
+{
+  if ( this != &other ) {
+    ByteStream copy { other };
+    *this = std::move( copy );
+  }
+  return *this;
+}
+
 uint64_t ByteStream::capacity() const
 {
   return capacity_;
 }
 
+bool ByteStream::compact()
+{
+  if ( chunks && chunks->buffer.empty() )
+    chunks.reset();
+  return !chunks;
+}
+
 void Writer::push( string data )
 {
   if ( data.empty() )
     return;
+  if ( !chunks )
+    chunks = make_unique<Chunks>();
   int toPushLen = min( (int)data.size(), (int)available_capacity() );
-  buffer_actual.push( std::move( data ) );
-  buffer.push( string_view( buffer_actual.back() ).substr( 0, toPushLen ) );
+  chunks->buffer_actual.push_back( std::move( data ) );
+  chunks->buffer.push_back( string_view( chunks->buffer_actual.back() ).substr( 0, toPushLen ) );
   bytesPushed += toPushLen;
   bytesBuffered += toPushLen;
 }
@@ -60,15 +96,15 @@ uint64_t Writer::bytes_pushed() const
 
 string_view Reader::peek() const
 {
-  if ( !buffer.empty() )
-    return buffer.front();
+  if ( chunks && !chunks->buffer.empty() )
+    return chunks->buffer.front();
   else
     return string_view();
 }
 
 bool Reader::is_finished() const
 {
-  return closed && buffer.empty();
+  return closed && ( !chunks || chunks->buffer.empty() );
 }
 
 bool Reader::has_error() const
@@ -78,6 +114,10 @@ bool Reader::has_error() const
 
 void Reader::pop( uint64_t len )
 {
+  if ( !chunks )
+    return;
+
+  auto& [buffer, buffer_actual] = *chunks;
   bytesPopped += len;
   for ( unsigned i = 0; i < len; ) {
     if ( buffer.front().size() > len - i ) {
@@ -85,13 +125,13 @@ void Reader::pop( uint64_t len )
       i = len;
     } else {
       i += buffer.front().size();
-      buffer.pop();
-      buffer_actual.pop();
+      buffer.pop_front();
+      buffer_actual.pop_front();
     }
   }
 
   while ( !buffer.empty() && buffer.front().empty() )
-    buffer.pop();
+    buffer.pop_front();
   bytesBuffered -= len;
 }
 
@@ -1,7 +1,7 @@
 #pragma once
 
 #include <deque>
-#include <queue>
+#include <memory>
 #include <stdexcept>
 #include <string>
 #include <string_view>
@@ -12,9 +12,20 @@ class Writer;
 class ByteStream
 {
 protected:
+  // The pushed strings, and views of what has not been popped from them. Allocated by the first push, and
+  // released by compact() once everything has been popped, so an idle stream holds no memory.
+  struct Chunks
+  {
+    std::deque<std::string_view> buffer {};
+    std::deque<std::string> buffer_actual {}; // the views are of the newest strings, one each
+
+    Chunks() = default;
+    Chunks( const Chunks& other ); // views of its own strings
+    Chunks& operator=( const Chunks& other ) = delete;
+  };
+
   uint64_t capacity_;
-  std::queue<std::string_view> buffer;
-  std::queue<std::string> buffer_actual;
+  std::unique_ptr<Chunks> chunks;
   bool closed;
   bool hasError;
   int bytesPopped;
@@ -24,6 +35,11 @@ protected:
 
 public:
   explicit ByteStream( uint64_t capacity );
+  ByteStream( const ByteStream& other );
+  ByteStream& operator=( const ByteStream& other );
+  ByteStream( ByteStream&& other ) noexcept = default;
+  ByteStream& operator=( ByteStream&& other ) noexcept = default;
+  ~ByteStream() = default;
 
   // Helper functions (provided) to access the ByteStream's Reader and Writer interfaces
   Reader& reader();
@@ -31,6 +47,10 @@ public:
   Writer& writer();
   const Writer& writer() const;
   uint64_t capacity() const;
+
+  // Release the memory behind the buffer if it is empty; the next push allocates it again. Returns whether
+  // the stream now holds no memory.
+  bool compact();
 };
 
 class Writer : public ByteStream
@@ -0,0 +1,88 @@
+#include "connection_table.hh"
+
+#include <stdexcept>
+
+using namespace std;
+
+ConnectionTable::ConnectionId ConnectionTable::add( const FourTuple& tuple )
+{
+  ConnectionId id {};
+  if ( free_ids_.empty() ) {
+    id = static_cast<ConnectionId>( connections_.size() );
+    connections_.emplace_back();
+  } else {
+    id = free_ids_.back();
+    free_ids_.pop_back();
+  }
+  connections_[id] = make_unique<Connection>( Connection { tuple, TCPPeer { config_ } } );
+  connections_by_tuple_[tuple] = id;
+  return id;
+}
+
+ConnectionTable::ConnectionId ConnectionTable::connect( const FourTuple& tuple )
+{
+  if ( connections_by_tuple_.contains( tuple ) ) {
+    throw runtime_error( "ConnectionTable: connection already exists" );
+  }
+  return add( tuple );
+}
+
+void ConnectionTable::listen( uint32_t ip, uint16_t port, size_t backlog )
+{
+  listeners_[listener_key( ip, port )].backlog = backlog;
+}
+
+optional<ConnectionTable::ConnectionId> ConnectionTable::accept( uint32_t ip, uint16_t port )
+{
+  Listener* listener = listeners_.find( listener_key( ip, port ) );
+  if ( not listener or listener->accept_queue.empty() ) {
+    return nullopt;
+  }
+  const ConnectionId id = listener->accept_queue.front();
+  listener->accept_queue.pop_front();
+  return id;
+}
+
+optional<ConnectionTable::ConnectionId> ConnectionTable::receive( uint32_t src_ip,
+                                                                  uint32_t dst_ip,
+                                                                  TCPSegment&& segment )
+{
+  const FourTuple tuple { dst_ip, src_ip, segment.dst_port, segment.src_port };
+  optional<ConnectionId> id = find( tuple );
+
+  if ( not id.has_value() ) {
+    Listener* listener = listeners_.find( listener_key( dst_ip, segment.dst_port ) );
+    if ( not segment.message.sender.SYN or segment.message.receiver.ackno.has_value() or not listener
+         or listener->accept_queue.size() >= listener->backlog ) {
+      return nullopt;
+    }
+    id = add( tuple );
+    listener->accept_queue.push_back( *id );
+  }
+
+  connections_[*id]->peer.receive( move( segment.message ) );
+  return id;
+}
+
+optional<ConnectionTable::ConnectionId> ConnectionTable::find( const FourTuple& tuple ) const
+{
+  const ConnectionId* id = connections_by_tuple_.find( tuple );
+  return id ? optional { *id } : nullopt;
+}
+
+void ConnectionTable::remove( ConnectionId id )
+{
+  if ( id >= connections_.size() or not connections_[id] ) {
+    throw out_of_range( "ConnectionTable: no such connection" );
+  }
+  const FourTuple& tuple = connections_[id]->tuple;
+
+  // A connection that was never accepted must not be handed out by accept() later
+  if ( Listener* listener = listeners_.find( listener_key( tuple.local_ip, tuple.local_port ) ) ) {
+    erase( listener->accept_queue, id );
+  }
+
+  connections_by_tuple_.erase( tuple );
+  connections_[id].reset();
+  free_ids_.push_back( id );
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "flat_hash_map.hh"
+#include "tcp_config.hh"
+#include "tcp_peer.hh"
+#include "tcp_segment.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <vector>
+
+// The addresses and ports that name a TCP connection, from this host's side
+struct FourTuple
+{
+  uint32_t local_ip {};
+  uint32_t remote_ip {};
+  uint16_t local_port {};
+  uint16_t remote_port {};
+
+  bool operator==( const FourTuple& other ) const = default;
+};
+
+struct FourTupleHash
+{
+  size_t operator()( const FourTuple& tuple ) const
+  {
+    const uint64_t addresses = uint64_t { tuple.local_ip } << 32 | tuple.remote_ip;
+    const uint64_t ports = uint64_t { tuple.local_port } << 16 | tuple.remote_port;
+    return FlatHash<uint64_t> {}( addresses ^ ( ports * 0x9e3779b97f4a7c15ULL ) );
+  }
+};
+
+// Finds the connection each incoming segment belongs to, among any number of them, and starts new ones for
+// SYNs that arrive at a listening port.
+//
+// The lookup table is a FlatHashMap from the 4-tuple to a 32-bit connection id, so its slots are 16 bytes
+// and a lookup usually touches one cache line of metadata and one of slots. The connections themselves
+// (each a TCPPeer, with its sender, receiver, reassembler and streams) live in a slab indexed by id, and
+// stay where they are while the table grows; ids of closed connections are reused.
+class ConnectionTable
+{
+public:
+  using ConnectionId = uint32_t;
+
+  struct Connection
+  {
+    FourTuple tuple;
+    TCPPeer peer;
+  };
+
+private:
+  // A listening port: the connections its SYNs started, waiting to be accepted
+  struct Listener
+  {
+    size_t backlog {};
+    std::deque<ConnectionId> accept_queue {};
+  };
+
+  TCPConfig config_;
+  FlatHashMap<FourTuple, ConnectionId, FourTupleHash> connections_by_tuple_ {};
+  std::vector<std::unique_ptr<Connection>> connections_ {}; // indexed by id; null if the id is free
+  std::vector<ConnectionId> free_ids_ {};
+  FlatHashMap<uint64_t, Listener> listeners_ {}; // keyed on the local address and port
+
+  static uint64_t listener_key( uint32_t ip, uint16_t port ) { return uint64_t { ip } << 16 | port; }
+  ConnectionId add( const FourTuple& tuple );
+
+public:
+  explicit ConnectionTable( const TCPConfig& config = {} ) : config_( config ) {}
+
+  // Start a connection to a remote address and port (the caller sends its SYN with the peer's maybe_send())
+  ConnectionId connect( const FourTuple& tuple );
+
+  // Accept connections to a local address and port, keeping up to `backlog` of them until accept()ed
+  void listen( uint32_t ip, uint16_t port, size_t backlog );
+
+  // The oldest connection started by a SYN to a listening address and port, if any
+  std::optional<ConnectionId> accept( uint32_t ip, uint16_t port );
+
+  // Hand a segment from `src_ip` to `dst_ip` to its connection. A SYN to a listening port with room in its
+  // backlog starts a new connection. Returns the connection, or nothing if the segment was dropped.
+  std::optional<ConnectionId> receive( uint32_t src_ip, uint32_t dst_ip, TCPSegment&& segment );
+
+  // The connection named by `tuple`, if any
+  std::optional<ConnectionId> find( const FourTuple& tuple ) const;
+
+  Connection& connection( ConnectionId id ) { return *connections_.at( id ); }
+  const Connection& connection( ConnectionId id ) const { return *connections_.at( id ); }
+
+  // Forget a connection (accepted or not); its id may be reused
+  void remove( ConnectionId id );
+
+  size_t size() const { return connections_by_tuple_.size(); }
+};
@@ -6,6 +6,8 @@
 #include "ipv4_datagram.hh"
 #include "parser.hh"
 
+#include <array>
+
 using namespace std;
 
 // ethernet_address: Ethernet (what ARP calls "hardware") address of the interface
@@ -13,11 +15,14 @@ using namespace std;
 NetworkInterface::NetworkInterface( const EthernetAddress& ethernet_address, const Address& ip_address )
   : ethernet_address_( ethernet_address )
   , ip_address_( ip_address )
-  , time_( 0 )
   , frames_()
-  , ip_to_ethernet_()
-  , ip_to_time_()
-  , ips_()
+  , arp_cache_()
+  , timers_()
+  , pending_datagrams_()
+  , n_pending_( 0 )
+  , n_dropped_( 0 )
+  , n_delayed_( 0 )
+  , refresh_lead_ms_( 0 )
 {
   cerr << "DEBUG: Network interface has Ethernet address " << to_string( ethernet_address_ ) << " and IP address "
        << ip_address.ip() << "\n";
@@ -25,30 +30,118 @@ NetworkInterface::NetworkInterface( const EthernetAddress& ethernet_address, con
 
 void NetworkInterface::pushARP( uint16_t opcode, uint32_t target_ip, EthernetAddress target_eth )
 {
-  Serializer serializer;
-  EthernetHeader header;
-  header.type = EthernetHeader::TYPE_ARP;
-  header.src = ethernet_address_;
-  header.dst = target_eth;
-
   ARPMessage payload;
   payload.opcode = opcode;
   payload.sender_ethernet_address = ethernet_address_;
   payload.sender_ip_address = ip_address_.ipv4_numeric();
-  if ( target_eth == boardcast_address ) {
+  if ( opcode == ARPMessage::OPCODE_REQUEST ) {
     payload.target_ethernet_address = {};
   } else {
     payload.target_ethernet_address = target_eth;
   }
   payload.target_ip_address = target_ip;
-  header.serialize( serializer );
+
+  EthernetFrame frame;
+  frame.header.type = EthernetHeader::TYPE_ARP;
+  frame.header.src = ethernet_address_;
+  frame.header.dst = target_eth;
+
+  array<char, ARPMessage::LENGTH> message {};
+  Serializer serializer { message };
   payload.serialize( serializer );
+  frame.payload = serializer.output();
+  frames_.push( move( frame ) );
+}
+
+void NetworkInterface::pushIPv4( const InternetDatagram& dgram, const EthernetAddress& dst )
+{
+  EthernetFrame frame;
+  frame.header.src = ethernet_address_;
+  frame.header.dst = dst;
+  frame.header.type = EthernetHeader::TYPE_IPv4;
+  frame.payload = serialize( dgram );
+  frames_.push( move( frame ) );
+}
+
+// Release every datagram that was waiting for `ip` to be resolved, in the order they were sent
+void NetworkInterface::releasePending( uint32_t ip, const EthernetAddress& dst )
+{
+  auto it = pending_datagrams_.find( ip );
+  if ( it == pending_datagrams_.end() )
+    return;
+
+  auto& queue = it->second;
+  n_pending_ -= queue.size();
+  while ( !queue.empty() ) {
+    pushIPv4( queue.front(), dst );
+    queue.pop();
+  }
+  pending_datagrams_.erase( it );
+}
 
-  Parser parser( serializer.output() );
+// Move the cache entry for `ip` (created if needed) to `state`, firing its timer `timeout_ms` from now
+NetworkInterface::ARPEntry& NetworkInterface::updateEntry( uint32_t ip, ARPEntry::State state, uint64_t timeout_ms )
+{
+  auto [entry, inserted] = arp_cache_.try_emplace( ip );
+  if ( inserted )
+    entry->timer = timers_.create( ip );
+  entry->state = state;
+  entry->updated_ms = timers_.now();
+  timers_.schedule_in( entry->timer, timeout_ms );
+  return *entry;
+}
+
+// Record a mapping learned from the network (static mappings are left alone)
+void NetworkInterface::learn( uint32_t ip, const EthernetAddress& ethernet_address )
+{
+  const ARPEntry* existing = arp_cache_.find( ip );
+  if ( existing && existing->state == ARPEntry::State::STATIC )
+    return;
+
+  const uint64_t reachable_ms = ARP_ENTRY_TTL_MS - refresh_lead_ms_;
+  ARPEntry& entry = updateEntry( ip, ARPEntry::State::REACHABLE, reachable_ms );
+  entry.ethernet_address = ethernet_address;
+  entry.used = pending_datagrams_.contains( ip );
+  releasePending( ip, ethernet_address );
+}
+
+void NetworkInterface::onTimeout( TimerWheel<uint32_t>::TimerId id, uint32_t ip )
+{
+  ARPEntry* entry = arp_cache_.find( ip );
+  if ( entry && entry->state == ARPEntry::State::INCOMPLETE && entry->requests < MAX_ARP_REQUESTS ) {
+    // Resend ARP requests if timeout
+    pushARP( ARPMessage::OPCODE_REQUEST, ip, boardcast_address );
+    entry->requests++;
+    timers_.schedule_in( id, ARP_REQUEST_TIMEOUT_MS );
+    return;
+  }
+
+  if ( entry && entry->state == ARPEntry::State::INCOMPLETE ) {
+    // The next hop never answered: drop what was waiting for it, and forget it until it is sent to again
+    auto it = pending_datagrams_.find( ip );
+    if ( it != pending_datagrams_.end() ) {
+      n_pending_ -= it->second.size();
+      n_dropped_ += it->second.size();
+      pending_datagrams_.erase( it );
+    }
+    arp_cache_.erase( ip );
+    timers_.destroy( id );
+    return;
+  }
+
+  if ( entry && entry->state == ARPEntry::State::REACHABLE && refresh_lead_ms_ > 0 ) {
+    // Close to expiry: keep using the mapping, and ask the neighbor to confirm it if it is in use
+    entry->state = ARPEntry::State::STALE;
+    entry->updated_ms = timers_.now();
+    timers_.schedule_in( id, refresh_lead_ms_ );
+    if ( entry->used )
+      pushARP( ARPMessage::OPCODE_REQUEST, ip, entry->ethernet_address );
+    return;
+  }
 
-  EthernetFrame frame_to_send;
-  frame_to_send.parse( parser );
-  frames_.push_front( frame_to_send );
+  // The learned mapping has expired
+  arp_cache_.erase( ip );
+  timers_.destroy( id );
 }
 
 // dgram: the IPv4 datagram to be sent
@@ -59,31 +152,33 @@ void NetworkInterface::pushARP( uint16_t opcode, uint32_t target_ip, EthernetAdd
 // Address::ipv4_numeric() method.
 void NetworkInterface::send_datagram( const InternetDatagram& dgram, const Address& next_hop )
 {
-  int32_t hop_addr = next_hop.ipv4_numeric();
+  const uint32_t hop_addr = next_hop.ipv4_numeric();
 
-  // ARP Request
-  if ( !ip_to_ethernet_.contains( hop_addr ) ) {
-    pushARP( ARPMessage::OPCODE_REQUEST, next_hop.ipv4_numeric(), boardcast_address );
-    ip_to_ethernet_[hop_addr] = boardcast_address;
-    ip_to_time_[hop_addr] = time_;
+  // Resolved next hop: the frame can go out right away
+  ARPEntry* entry = arp_cache_.find( hop_addr );
+  if ( entry && entry->state != ARPEntry::State::INCOMPLETE ) {
+    pushIPv4( dgram, entry->ethernet_address );
+    if ( entry->state == ARPEntry::State::STALE && !entry->used )
+      pushARP( ARPMessage::OPCODE_REQUEST, hop_addr, entry->ethernet_address );
+    entry->used = true;
+    return;
   }
 
-  // Queue the IP datagram
-  EthernetHeader header;
-  Serializer serializer;
-  header.src = ethernet_address_;
-  // destination ethernet address will be filled when sending
-  header.type = EthernetHeader::TYPE_IPv4;
-
-  header.serialize( serializer );
-  dgram.serialize( serializer );
-
-  Parser parser( serializer.output() );
-  EthernetFrame frame;
-  frame.parse( parser );
-  frames_.push_back( frame );
+  // ARP Request
+  if ( !entry ) {
+    pushARP( ARPMessage::OPCODE_REQUEST, hop_addr, boardcast_address );
+    updateEntry( hop_addr, ARPEntry::State::INCOMPLETE, ARP_REQUEST_TIMEOUT_MS ).requests = 1;
+  }
 
-  ips_.push_back( hop_addr );
+  // Hold the datagram until the reply arrives, dropping it if this hop already has a full queue
+  auto& queue = pending_datagrams_[hop_addr];
+  if ( queue.size() >= MAX_PENDING_PER_HOP ) {
+    n_dropped_++;
+    return;
+  }
+  queue.push( dgram );
+  n_pending_++;
+  n_delayed_++;
 }
 
 // frame: the incoming Ethernet frame
@@ -97,16 +192,18 @@ optional<InternetDatagram> NetworkInterface::recv_frame( const EthernetFrame& fr
   if ( frame.header.type == EthernetHeader::TYPE_ARP ) {
     ARPMessage arp;
     arp.parse( parser );
-    // If not inbound, ignore it
-    if ( parser.has_error() || arp.target_ip_address != ip_address_.ipv4_numeric() )
+    if ( parser.has_error() )
       return {};
 
-    // If inbound, remember it
-    ip_to_ethernet_[arp.sender_ip_address] = arp.sender_ethernet_address;
-    if ( !ip_to_time_.contains( arp.sender_ip_address ) )
-      ip_to_time_[arp.sender_ip_address] = time_;
+    // Remember mappings sent to us, gratuitous announcements, and news of neighbors we already know
+    const uint32_t own_ip = ip_address_.ipv4_numeric();
+    const bool inbound = arp.target_ip_address == own_ip;
+    const bool gratuitous = arp.sender_ip_address == arp.target_ip_address;
+    if ( arp.sender_ip_address != own_ip
+         && ( inbound || gratuitous || arp_cache_.contains( arp.sender_ip_address ) ) )
+      learn( arp.sender_ip_address, arp.sender_ethernet_address );
 
-    if ( arp.opcode == ARPMessage::OPCODE_REQUEST )
+    if ( inbound && arp.opcode == ARPMessage::OPCODE_REQUEST )
       pushARP( ARPMessage::OPCODE_REPLY, arp.sender_ip_address, frame.header.src );
 
   } else if ( frame.header.type == EthernetHeader::TYPE_IPv4 ) {
@@ -116,24 +213,44 @@ optional<InternetDatagram> NetworkInterface::recv_frame( const EthernetFrame& fr
     if ( parser.has_error() )
       return {};
 
+    // A datagram sent directly by a neighbor confirms the mapping we hold for it
+    const ARPEntry* entry = arp_cache_.find( datg.header.src );
+    if ( entry && entry->state != ARPEntry::State::INCOMPLETE && entry->ethernet_address == frame.header.src )
+      learn( datg.header.src, frame.header.src );
+
     return datg;
   }
   return {};
 }
 
+void NetworkInterface::add_static_neighbor( const Address& ip, const EthernetAddress& ethernet_address )
+{
+  const uint32_t ip_numeric = ip.ipv4_numeric();
+  auto [entry, inserted] = arp_cache_.try_emplace( ip_numeric );
+  if ( inserted )
+    entry->timer = timers_.create( ip_numeric );
+  timers_.cancel( entry->timer );
+  entry->state = ARPEntry::State::STATIC;
+  entry->ethernet_address = ethernet_address;
+  entry->updated_ms = timers_.now();
+  releasePending( ip_numeric, ethernet_address );
+}
+
+void NetworkInterface::announce()
+{
+  pushARP( ARPMessage::OPCODE_REQUEST, ip_address_.ipv4_numeric(), boardcast_address );
+}
+
+void NetworkInterface::set_refresh_lead( uint64_t lead_ms )
+{
+  refresh_lead_ms_ = min( lead_ms, ARP_ENTRY_TTL_MS );
+}
+
 // ms_since_last_tick: the number of milliseconds since the last call to this method
 void NetworkInterface::tick( const size_t ms_since_last_tick )
 {
-  time_ += ms_since_last_tick;
-  for ( auto& [ip, t] : ip_to_time_ ) {
-    // Resend ARP requests if timeout
-    if ( ip_to_ethernet_[ip] == boardcast_address && time_ - t >= 5000 ) {
-      pushARP( ARPMessage::OPCODE_REQUEST, ip, boardcast_address );
-      ip_to_time_[ip] = time_;
-    } else if ( time_ - t >= 30000 ) {
-      ip_to_ethernet_.erase( ip );
-    }
-  }
+  timers_.advance( ms_since_last_tick,
+                   [this]( TimerWheel<uint32_t>::TimerId id, uint32_t ip ) { onTimeout( id, ip ); } );
 }
 
 optional<EthernetFrame> NetworkInterface::maybe_send()
@@ -141,19 +258,28 @@ optional<EthernetFrame> NetworkInterface::maybe_send()
   if ( frames_.empty() )
     return {};
 
-  EthernetFrame frame = frames_.front();
-  if ( frame.header.type == EthernetHeader::TYPE_ARP ) {
-    frames_.pop_front();
-    return frame;
-  } else if ( frame.header.type == EthernetHeader::TYPE_IPv4 ) {
-    if ( !ip_to_ethernet_.contains( ips_.front() ) || ip_to_ethernet_[ips_.front()] == boardcast_address )
-      return {};
+  EthernetFrame frame = move( frames_.front() );
+  frames_.pop();
+  return frame;
+}
 
-    frame.header.dst = ip_to_ethernet_[ips_.front()];
-    ips_.pop_front();
-    frames_.pop_front();
-    return frame;
+size_t NetworkInterface::send_burst( span<EthernetFrame> frames )
+{
+  size_t n = 0;
+  while ( n < frames.size() && !frames_.empty() ) {
+    frames[n++] = move( frames_.front() );
+    frames_.pop();
   }
+  return n;
+}
 
-  return {};
+size_t NetworkInterface::recv_burst( span<const EthernetFrame> frames, vector<InternetDatagram>& datagrams )
+{
+  const size_t before = datagrams.size();
+  for ( const auto& frame : frames ) {
+    auto dgram = recv_frame( frame );
+    if ( dgram.has_value() )
+      datagrams.push_back( move( dgram.value() ) );
+  }
+  return datagrams.size() - before;
 }
@@ -3,7 +3,9 @@
 #include "address.hh"
 #include "ethernet_frame.hh"
 #include "ethernet_header.hh"
+#include "flat_hash_map.hh"
 #include "ipv4_datagram.hh"
+#include "timer_wheel.hh"
 
 #include <cstdint>
 #include <deque>
@@ -12,8 +14,10 @@
 #include <map>
 #include <optional>
 #include <queue>
+#include <span>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 // A "network interface" that connects IP (the internet layer, or network layer)
 // with Ethernet (the network access layer, or link layer).
@@ -40,6 +44,33 @@ class NetworkInterface
 {
   constexpr static EthernetAddress boardcast_address = { 0xff, 0xff, 0xff, 0xff, 0xff, 0xff };
 
+public:
+  // Maximum number of datagrams held for one next hop while its Ethernet address is being resolved
+  static constexpr size_t MAX_PENDING_PER_HOP = 64;
+
+  static constexpr uint64_t ARP_REQUEST_TIMEOUT_MS = 5000; // Resend an unanswered ARP request after this long
+  static constexpr uint8_t MAX_ARP_REQUESTS = 3;           // Give up on a next hop after this many requests
+  static constexpr uint64_t ARP_ENTRY_TTL_MS = 30000;      // Forget a learned mapping after this long
+
+  // An ARP cache entry, stored inline in the cache's table
+  struct ARPEntry
+  {
+    enum class State : uint8_t
+    {
+      INCOMPLETE, // request sent, waiting for a reply
+      REACHABLE,  // mapping learned
+      STALE,      // mapping still usable, but about to expire unless reconfirmed
+      STATIC,     // mapping configured by the owner; never expires
+    };
+
+    EthernetAddress ethernet_address {};
+    State state {};
+    bool used {};        // sent to since learned (reachable), or refresh already requested (stale)
+    uint8_t requests {}; // requests sent without a reply (incomplete)
+    TimerWheel<uint32_t>::TimerId timer {}; // retransmits the request or expires the mapping
+    uint64_t updated_ms {};                 // when the entry last changed state
+  };
+
 private:
   // Ethernet (known as hardware, network-access, or link-layer) address of the interface
   EthernetAddress ethernet_address_;
@@ -47,14 +78,30 @@ private:
   // IP (known as Internet-layer or network-layer) address of the interface
   Address ip_address_;
 
-  size_t time_;
+  // Frames ready for transmission, in the order they were generated
+  std::queue<EthernetFrame> frames_;
+
+  // ARP cache keyed on IPv4 address. Each entry owns a timer: request retransmission while
+  // incomplete, expiry once reachable. tick() only touches the entries whose timers fire.
+  FlatHashMap<uint32_t, ARPEntry> arp_cache_;
+  TimerWheel<uint32_t> timers_;
+
+  // Datagrams waiting for ARP resolution, queued separately for each next hop so that
+  // an unresolved neighbor never holds back traffic to resolved ones
+  std::unordered_map<uint32_t, std::queue<InternetDatagram>> pending_datagrams_;
+  size_t n_pending_;
+  size_t n_dropped_;
+  size_t n_delayed_;
 
-  std::deque<EthernetFrame> frames_;
-  std::unordered_map<uint32_t, EthernetAddress> ip_to_ethernet_;
-  std::unordered_map<uint32_t, size_t> ip_to_time_;
-  std::deque<uint32_t> ips_;
+  // How long before expiry a mapping in use is re-requested (0: never)
+  uint64_t refresh_lead_ms_;
 
   void pushARP( uint16_t opcode, uint32_t target_ip, EthernetAddress target_eth );
+  void pushIPv4( const InternetDatagram& dgram, const EthernetAddress& dst );
+  void releasePending( uint32_t ip, const EthernetAddress& dst );
+  ARPEntry& updateEntry( uint32_t ip, ARPEntry::State state, uint64_t timeout_ms );
+  void learn( uint32_t ip, const EthernetAddress& ethernet_address );
+  void onTimeout( TimerWheel<uint32_t>::TimerId id, uint32_t ip );
 
 public:
   // Construct a network interface with given Ethernet (network-access-layer) and IP (internet-layer)
@@ -77,6 +124,33 @@ public:
   // If type is ARP reply, learn a mapping from the "sender" fields.
   std::optional<InternetDatagram> recv_frame( const EthernetFrame& frame );
 
+  // Batched counterparts of maybe_send() and recv_frame(), for adapters that move many frames per
+  // system call. send_burst() moves up to `frames.size()` frames awaiting transmission into `frames`
+  // and returns how many it wrote; recv_burst() handles every frame in `frames`, appends the received
+  // datagrams to `datagrams`, and returns how many it appended.
+  size_t send_burst( std::span<EthernetFrame> frames );
+  size_t recv_burst( std::span<const EthernetFrame> frames, std::vector<InternetDatagram>& datagrams );
+
   // Called periodically when time elapses
   void tick( size_t ms_since_last_tick );
+
+  // Install a permanent mapping for `ip`, e.g. for a default gateway: datagrams to it never wait for
+  // ARP, and the mapping neither expires nor is overwritten by ARP traffic
+  void add_static_neighbor( const Address& ip, const EthernetAddress& ethernet_address );
+
+  // Broadcast a gratuitous ARP announcing this interface's mapping, so neighbors learn it up front
+  void announce();
+
+  // Re-request a mapping that is in use `lead_ms` before it would expire, so that busy neighbors
+  // never fall back to the unresolved state (0, the default, disables refreshing)
+  void set_refresh_lead( uint64_t lead_ms );
+
+  // Number of datagrams that have had to wait for their next hop to be resolved
+  size_t delayed_datagrams() const { return n_delayed_; }
+
+  // Number of datagrams currently waiting for their next hop to be resolved
+  size_t pending_datagrams() const { return n_pending_; }
+
+  // Number of datagrams dropped because their next hop's pending queue was full, or it never answered ARP
+  size_t dropped_datagrams() const { return n_dropped_; }
 };
@@ -0,0 +1,197 @@
+#include "network_simulator.hh"
+#include "tcp_segment.hh"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+using namespace std;
+
+namespace {
+
+constexpr SimTime TICK = 1000; // hosts and routers have their timers ticked every millisecond
+
+} // namespace
+
+Simulator::Simulator( uint64_t seed ) : random_( seed ) {}
+
+Simulator::~Simulator() = default;
+
+void Simulator::at( SimTime time, function<void()> action )
+{
+  if ( time < now_ ) {
+    throw runtime_error( "Simulator: cannot schedule an event in the past" );
+  }
+  events_.push_back( { time, next_sequence_++, move( action ) } );
+  push_heap( events_.begin(), events_.end(), greater<> {} );
+}
+
+void Simulator::every( SimTime period, function<void()> action )
+{
+  after( period, [this, period, action = move( action )]() mutable {
+    action();
+    every( period, move( action ) );
+  } );
+}
+
+void Simulator::run_until( SimTime end )
+{
+  while ( not events_.empty() and events_.front().time <= end ) {
+    pop_heap( events_.begin(), events_.end(), greater<> {} );
+    Event event = move( events_.back() );
+    events_.pop_back();
+
+    now_ = event.time;
+    event.action();
+    events_run_++;
+  }
+  now_ = max( now_, end );
+}
+
+SimulatedLink& Simulator::add_link( const LinkConfig& config )
+{
+  return *links_.emplace_back( make_unique<SimulatedLink>( *this, config ) );
+}
+
+SimulatedHost& Simulator::add_host( const EthernetAddress& ethernet_address,
+                                    const Address& ip_address,
+                                    const Address& gateway,
+                                    TCPConfig config )
+{
+  // Initial sequence numbers come from the seeded generator too, so runs repeat exactly
+  if ( not config.fixed_isn.has_value() ) {
+    config.fixed_isn = Wrap32 { static_cast<uint32_t>( random_() ) };
+  }
+  return *hosts_.emplace_back( make_unique<SimulatedHost>( *this, ethernet_address, ip_address, gateway, config ) );
+}
+
+SimulatedRouter& Simulator::add_router()
+{
+  return *routers_.emplace_back( make_unique<SimulatedRouter>( *this ) );
+}
+
+void SimulatedLink::send( size_t end, EthernetFrame&& frame )
+{
+  Direction& direction = directions_.at( end );
+  if ( direction.queued >= config_.queue_depth ) {
+    direction.stats.queue_drops++;
+    return;
+  }
+
+  const uint64_t bytes = EthernetHeader::LENGTH + frame.payload.length();
+  const SimTime transmitted = max( sim_.now(), direction.busy_until ) + bytes * 8'000'000 / config_.bits_per_second;
+  direction.busy_until = transmitted;
+  direction.queued++;
+  direction.stats.frames_sent++;
+  direction.stats.bytes_sent += bytes;
+
+  sim_.at( transmitted, [this, end, frame = move( frame )]() mutable {
+    Direction& sender = directions_[end];
+    sender.queued--;
+    if ( config_.loss > 0 and uniform_real_distribution<double> { 0, 1 }( sim_.random() ) < config_.loss ) {
+      sender.stats.losses++;
+      return;
+    }
+    sim_.after( config_.delay, [this, end, frame = move( frame )]() mutable {
+      if ( const Receiver& receiver = receivers_[1 - end] ) {
+        receiver( move( frame ) );
+      }
+    } );
+  } );
+}
+
+SimulatedHost::SimulatedHost( Simulator& sim,
+                              const EthernetAddress& ethernet_address,
+                              const Address& ip_address,
+                              const Address& gateway,
+                              const TCPConfig& config )
+  : sim_( sim )
+  , interface_( ethernet_address, ip_address )
+  , ip_address_( ip_address.ipv4_numeric() )
+  , gateway_( gateway )
+  , peer_( config )
+{
+  sim_.every( TICK, [this] {
+    interface_.tick( TICK / 1000 );
+    peer_.tick( TICK / 1000 );
+    transmit();
+  } );
+}
+
+void SimulatedHost::connect( SimulatedLink& link, size_t end )
+{
+  link_ = &link;
+  end_ = end;
+  link.attach( end, [this]( EthernetFrame&& frame ) { receive( move( frame ) ); } );
+}
+
+void SimulatedHost::open( const Address& remote, Application app )
+{
+  remote_ip_ = remote.ipv4_numeric();
+  app_ = move( app );
+  sim_.after( 0, [this] { transmit(); } );
+}
+
+void SimulatedHost::receive( EthernetFrame&& frame )
+{
+  const optional<InternetDatagram> datagram = interface_.recv_frame( frame );
+  TCPSegment segment;
+  if ( datagram.has_value() and datagram->header.src == remote_ip_ and segment.parse_datagram( *datagram ) ) {
+    peer_.receive( move( segment.message ) );
+  }
+  transmit();
+}
+
+// Let the application have its turn, then send whatever the peer and the interface have to send
+void SimulatedHost::transmit()
+{
+  if ( app_ ) {
+    app_( peer_ );
+    peer_.push();
+    while ( auto message = peer_.maybe_send() ) {
+      TCPSegment segment;
+      segment.message = move( *message );
+      interface_.send_datagram( segment.to_datagram( ip_address_, remote_ip_ ), gateway_ );
+    }
+  }
+
+  while ( auto frame = interface_.maybe_send() ) {
+    if ( link_ ) {
+      link_->send( end_, move( *frame ) );
+    }
+  }
+}
+
+SimulatedRouter::SimulatedRouter( Simulator& sim ) : sim_( sim )
+{
+  sim_.every( TICK, [this] {
+    for ( size_t i = 0; i < links_.size(); i++ ) {
+      router_.interface( i ).tick( TICK / 1000 );
+    }
+    transmit();
+  } );
+}
+
+size_t SimulatedRouter::add_interface( const EthernetAddress& ethernet_address,
+                                       const Address& ip_address,
+                                       SimulatedLink& link,
+                                       size_t end )
+{
+  const size_t n = router_.add_interface( AsyncNetworkInterface { ethernet_address, ip_address } );
+  links_.emplace_back( &link, end );
+  link.attach( end, [this, n]( EthernetFrame&& frame ) {
+    router_.interface( n ).recv_frame( frame );
+    router_.route();
+    transmit();
+  } );
+  return n;
+}
+
+void SimulatedRouter::transmit()
+{
+  for ( size_t i = 0; i < links_.size(); i++ ) {
+    while ( auto frame = router_.interface( i ).maybe_send() ) {
+      links_[i].first->send( links_[i].second, move( *frame ) );
+    }
+  }
+}
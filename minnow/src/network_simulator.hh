@@ -0,0 +1,203 @@
+#pragma once
+
+#include "ethernet_frame.hh"
+#include "network_interface.hh"
+#include "router.hh"
+#include "tcp_config.hh"
+#include "tcp_peer.hh"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <random>
+#include <vector>
+
+// Virtual time, in microseconds
+using SimTime = uint64_t;
+
+class SimulatedLink;
+class SimulatedHost;
+class SimulatedRouter;
+
+struct LinkConfig
+{
+  uint64_t bits_per_second = 100'000'000; // transmission rate, each way
+  SimTime delay = 1000;                   // propagation delay
+  double loss = 0;                        // probability that a frame is lost in transit
+  size_t queue_depth = 100;               // frames that can wait for the transmitter before more are dropped
+};
+
+// A discrete-event network simulation: a virtual clock, the events scheduled on it, and the links, hosts and
+// routers they move frames between.
+//
+// Events run in time order, and those due at the same time in the order they were scheduled. All randomness
+// (link losses, initial sequence numbers) comes from one generator seeded by the caller, so a run depends
+// on nothing but its seed. Time only passes between events, so minutes of traffic take as long to simulate
+// as the events in them.
+class Simulator
+{
+  struct Event
+  {
+    SimTime time;
+    uint64_t sequence; // breaks ties between events due at the same time
+    std::function<void()> action;
+
+    bool operator>( const Event& other ) const
+    {
+      return time != other.time ? time > other.time : sequence > other.sequence;
+    }
+  };
+
+  std::vector<Event> events_ {}; // a min-heap on (time, sequence)
+  SimTime now_ {};
+  uint64_t next_sequence_ {};
+  uint64_t events_run_ {};
+  std::mt19937_64 random_;
+
+  std::vector<std::unique_ptr<SimulatedLink>> links_ {};
+  std::vector<std::unique_ptr<SimulatedHost>> hosts_ {};
+  std::vector<std::unique_ptr<SimulatedRouter>> routers_ {};
+
+public:
+  explicit Simulator( uint64_t seed );
+  ~Simulator();
+
+  Simulator( const Simulator& other ) = delete;
+  Simulator& operator=( const Simulator& other ) = delete;
+
+  SimTime now() const { return now_; }
+  uint64_t events_run() const { return events_run_; }
+  std::mt19937_64& random() { return random_; }
+
+  // Run `action` at `time` (no earlier than now()), after `delay`, or every `period` from now on
+  void at( SimTime time, std::function<void()> action );
+  void after( SimTime delay, std::function<void()> action ) { at( now_ + delay, std::move( action ) ); }
+  void every( SimTime period, std::function<void()> action );
+
+  // Run the events due up to `end`, then move the clock to `end`
+  void run_until( SimTime end );
+
+  // The network, owned by the Simulator
+  SimulatedLink& add_link( const LinkConfig& config );
+  SimulatedHost& add_host( const EthernetAddress& ethernet_address,
+                           const Address& ip_address,
+                           const Address& gateway,
+                           TCPConfig config = {} );
+  SimulatedRouter& add_router();
+};
+
+// A point-to-point Ethernet link with two ends, 0 and 1. Each direction transmits one frame at a time, at the
+// link's rate; frames sent while it is busy wait in a drop-tail queue. A transmitted frame reaches the far
+// end after the propagation delay, unless it is lost on the way.
+class SimulatedLink
+{
+public:
+  using Receiver = std::function<void( EthernetFrame&& )>;
+
+  struct Stats
+  {
+    uint64_t frames_sent {};
+    uint64_t bytes_sent {};
+    uint64_t queue_drops {}; // frames refused because the queue was full
+    uint64_t losses {};      // frames lost in transit
+  };
+
+private:
+  struct Direction
+  {
+    SimTime busy_until {}; // when the transmitter finishes the frames already queued
+    size_t queued {};      // frames waiting or being transmitted
+    Stats stats {};
+  };
+
+  Simulator& sim_;
+  LinkConfig config_;
+  std::array<Direction, 2> directions_ {};   // indexed by the sending end
+  std::array<Receiver, 2> receivers_ {};     // indexed by the receiving end
+
+public:
+  SimulatedLink( Simulator& sim, const LinkConfig& config ) : sim_( sim ), config_( config ) {}
+
+  SimulatedLink( const SimulatedLink& other ) = delete;
+  SimulatedLink& operator=( const SimulatedLink& other ) = delete;
+
+  // Deliver frames arriving at `end` to `receiver`
+  void attach( size_t end, Receiver receiver ) { receivers_.at( end ) = std::move( receiver ); }
+
+  // Queue a frame for transmission from `end` to the other one
+  void send( size_t end, EthernetFrame&& frame );
+
+  // Traffic sent from `end`
+  const Stats& stats( size_t end ) const { return directions_.at( end ).stats; }
+};
+
+// A host with one network interface, talking TCP (with a TCPPeer) to one remote host. The application is
+// called after every event at the host, to write to or read from the peer's streams.
+class SimulatedHost
+{
+public:
+  using Application = std::function<void( TCPPeer& )>;
+
+private:
+  Simulator& sim_;
+  NetworkInterface interface_;
+  uint32_t ip_address_;
+  Address gateway_;
+  TCPPeer peer_;
+  uint32_t remote_ip_ {};
+  Application app_ {};
+  SimulatedLink* link_ {};
+  size_t end_ {};
+
+  void receive( EthernetFrame&& frame );
+  void transmit();
+
+public:
+  SimulatedHost( Simulator& sim,
+                 const EthernetAddress& ethernet_address,
+                 const Address& ip_address,
+                 const Address& gateway,
+                 const TCPConfig& config );
+
+  SimulatedHost( const SimulatedHost& other ) = delete;
+  SimulatedHost& operator=( const SimulatedHost& other ) = delete;
+
+  // Plug the host's interface into `end` of `link`
+  void connect( SimulatedLink& link, size_t end );
+
+  // Start talking TCP to `remote`, with `app` using the connection
+  void open( const Address& remote, Application app );
+
+  TCPPeer& peer() { return peer_; }
+  const NetworkInterface& interface() const { return interface_; }
+};
+
+// A Router, each of whose interfaces is plugged into a link
+class SimulatedRouter
+{
+  Simulator& sim_;
+  Router router_ {};
+  std::vector<std::pair<SimulatedLink*, size_t>> links_ {}; // the link and end of each interface
+
+  void transmit();
+
+public:
+  explicit SimulatedRouter( Simulator& sim );
+
+  SimulatedRouter( const SimulatedRouter& other ) = delete;
+  SimulatedRouter& operator=( const SimulatedRouter& other ) = delete;
+
+  // Add an interface plugged into `end` of `link`; returns its number, for add_route()
+  size_t add_interface( const EthernetAddress& ethernet_address,
+                        const Address& ip_address,
+                        SimulatedLink& link,
+                        size_t end );
+
+  void add_route( uint32_t route_prefix, uint8_t prefix_length, std::optional<Address> next_hop, size_t interface )
+  {
+    router_.add_route( route_prefix, prefix_length, std::move( next_hop ), interface );
+  }
+};
@@ -13,9 +13,6 @@ void Reassembler::insert( uint64_t first_index, string data, bool is_last_substr
   (void)is_last_substring;
   (void)output;
 
-  if ( buf.empty() )
-    buf.resize( output.capacity() );
-
   uint64_t bias_push = output.bytes_pushed();
   uint64_t insert_l = max( output.bytes_pushed(), first_index );
   uint64_t insert_r = min( first_index + data.size() - 1, output.available_capacity() + bias_push - 1 );
@@ -33,6 +30,11 @@ void Reassembler::insert( uint64_t first_index, string data, bool is_last_substr
   if ( insert_l > insert_r )
     return;
 
+  // Only a segment with bytes to store needs the buffer, so a connection that has seen nothing but its SYN
+  // has not allocated one yet
+  if ( buf.empty() )
+    buf.resize( output.capacity() );
+
   for ( uint64_t i = insert_l; i <= insert_r; i++ ) {
     buf[i - bias_push] = data[i - first_index];
   }
@@ -92,3 +94,10 @@ uint64_t Reassembler::bytes_pending() const
 {
   return pending;
 }
+
+bool Reassembler::compact()
+{
+  if ( pending == 0 )
+    string().swap( buf );
+  return buf.empty();
+}
@@ -36,6 +36,10 @@ public:
   // How many bytes are stored in the Reassembler itself?
   uint64_t bytes_pending() const;
 
+  // Release the reassembly buffer if nothing is stored in it; the next insert with data allocates it again.
+  // Returns whether the buffer is now released.
+  bool compact();
+
 private:
   std::map<uint64_t, uint64_t> buffer;
   std::string buf;
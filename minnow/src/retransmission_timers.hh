@@ -0,0 +1,45 @@
+#pragma once
+
+#include "tcp_sender.hh"
+#include "timer_wheel.hh"
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * One clock for the retransmission timers of many TCPSenders, kept in a hierarchical TimerWheel.
+ *
+ * A sender that uses_timers() starts, stops and restarts its timer in the wheel in O(1), and ignores
+ * its own tick(). Advancing the wheel then costs nothing for senders whose timers are stopped, and only
+ * visits the ones whose timers expire, rather than every sender on every tick.
+ */
+class RetransmissionTimers
+{
+  friend class TCPSender;
+
+  TimerWheel<TCPSender*> wheel_ {};
+
+public:
+  /* Milliseconds since the RetransmissionTimers were created */
+  uint64_t now() const { return wheel_.now(); }
+
+  /* How many senders have a timer running? */
+  size_t running() const { return wheel_.size(); }
+
+  /* Move time forward by `ms`. Each sender whose timer expires handles the timeout as its tick() would
+   * (marking the earliest outstanding segment for retransmission, backing off and restarting the timer),
+   * and then on_expire( sender ) is called, e.g. to send that segment. */
+  template<typename F>
+  void advance( uint64_t ms, F&& on_expire )
+  {
+    wheel_.advance( ms, [&]( TimerWheel<TCPSender*>::TimerId /* id */, TCPSender* sender ) {
+      sender->expire();
+      on_expire( *sender );
+    } );
+  }
+
+  void advance( uint64_t ms )
+  {
+    advance( ms, []( TCPSender& /* sender */ ) {} );
+  }
+};
@@ -35,6 +35,14 @@ public:
     }
   };
 
+  // Receives a burst of Ethernet frames, queueing any IPv4 datagrams for maybe_receive()
+  void recv_burst( std::span<const EthernetFrame> frames )
+  {
+    for ( const auto& frame : frames ) {
+      recv_frame( frame );
+    }
+  }
+
   // Access queue of Internet datagrams that have been received
   std::optional<InternetDatagram> maybe_receive()
   {
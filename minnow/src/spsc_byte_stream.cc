@@ -0,0 +1,169 @@
+#include "spsc_byte_stream.hh"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <linux/futex.h>
+#include <stdexcept>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+uint32_t* futex_word( atomic<uint32_t>& word )
+{
+  static_assert( sizeof( atomic<uint32_t> ) == sizeof( uint32_t ) and atomic<uint32_t>::is_always_lock_free );
+  return reinterpret_cast<uint32_t*>( &word ); // NOLINT(*-reinterpret-cast)
+}
+
+// Sleep while `word` still holds `expected`. Returning early (on a signal, or because it no longer does) is
+// harmless, since the caller checks again what it was waiting for.
+void futex_wait( atomic<uint32_t>& word, uint32_t expected )
+{
+  ::syscall( SYS_futex, futex_word( word ), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0 );
+}
+
+void futex_wake( atomic<uint32_t>& word )
+{
+  ::syscall( SYS_futex, futex_word( word ), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0 );
+}
+
+} // namespace
+
+SPSCByteStream::SPSCByteStream( uint64_t capacity )
+  : capacity_( capacity ), mask_( bit_ceil( capacity ) - 1 ), ring_( make_unique<char[]>( mask_ + 1 ) )
+{}
+
+// The waiter announces itself and then checks for progress; the other side publishes progress and then
+// checks for a waiter. The fences between make sure at least one of them sees what the other did, so a
+// wake-up is never lost, and the futex system call is only made when somebody is asleep.
+void SPSCByteStream::wake( Wakeup& wakeup )
+{
+  atomic_thread_fence( memory_order_seq_cst );
+  if ( wakeup.waiting.load( memory_order_relaxed ) ) {
+    wakeup.sequence.fetch_add( 1, memory_order_release );
+    futex_wake( wakeup.sequence );
+  }
+}
+
+template<typename Ready>
+void SPSCByteStream::wait_until( Wakeup& wakeup, Ready&& ready )
+{
+  while ( not ready() ) {
+    const uint32_t sequence = wakeup.sequence.load( memory_order_acquire );
+    wakeup.waiting.store( true, memory_order_relaxed );
+    atomic_thread_fence( memory_order_seq_cst );
+    if ( not ready() ) {
+      futex_wait( wakeup.sequence, sequence );
+    }
+    wakeup.waiting.store( false, memory_order_relaxed );
+  }
+}
+
+uint64_t SPSCByteStream::push( string_view data )
+{
+  const uint64_t pushed = pushed_.load( memory_order_relaxed );
+  if ( capacity_ - ( pushed - popped_seen_ ) < data.size() ) {
+    popped_seen_ = popped_.load( memory_order_acquire );
+  }
+  const uint64_t len = min<uint64_t>( data.size(), capacity_ - ( pushed - popped_seen_ ) );
+  if ( len == 0 ) {
+    return 0;
+  }
+
+  // Copy the data in, in two pieces if it wraps around the end of the ring
+  const uint64_t start = pushed & mask_;
+  const uint64_t first = min( len, mask_ + 1 - start );
+  memcpy( ring_.get() + start, data.data(), first );
+  memcpy( ring_.get(), data.data() + first, len - first );
+
+  pushed_.store( pushed + len, memory_order_release );
+  wake( readable_ );
+  return len;
+}
+
+void SPSCByteStream::close()
+{
+  closed_.store( true, memory_order_release );
+  wake( readable_ );
+}
+
+void SPSCByteStream::set_error()
+{
+  error_.store( true, memory_order_release );
+  wake( readable_ );
+  wake( writable_ );
+}
+
+bool SPSCByteStream::is_closed() const
+{
+  return closed_.load( memory_order_acquire );
+}
+
+uint64_t SPSCByteStream::available_capacity() const
+{
+  return capacity_ - ( pushed_.load( memory_order_acquire ) - popped_.load( memory_order_acquire ) );
+}
+
+uint64_t SPSCByteStream::bytes_pushed() const
+{
+  return pushed_.load( memory_order_acquire );
+}
+
+void SPSCByteStream::wait_writable()
+{
+  wait_until( writable_, [this] { return available_capacity() > 0 or has_error(); } );
+}
+
+string_view SPSCByteStream::peek() const
+{
+  const uint64_t popped = popped_.load( memory_order_relaxed );
+  if ( pushed_seen_ == popped ) {
+    pushed_seen_ = pushed_.load( memory_order_acquire );
+  }
+  const uint64_t start = popped & mask_;
+  return { ring_.get() + start, min( pushed_seen_ - popped, mask_ + 1 - start ) };
+}
+
+void SPSCByteStream::pop( uint64_t len )
+{
+  const uint64_t popped = popped_.load( memory_order_relaxed );
+  if ( pushed_seen_ - popped < len ) {
+    pushed_seen_ = pushed_.load( memory_order_acquire );
+    if ( pushed_seen_ - popped < len ) {
+      throw runtime_error( "SPSCByteStream: popped more than was buffered" );
+    }
+  }
+
+  popped_.store( popped + len, memory_order_release );
+  wake( writable_ );
+}
+
+bool SPSCByteStream::is_finished() const
+{
+  // Once closed, nothing more is pushed, so the count loaded afterwards is final
+  return closed_.load( memory_order_acquire )
+         and pushed_.load( memory_order_acquire ) == popped_.load( memory_order_relaxed );
+}
+
+bool SPSCByteStream::has_error() const
+{
+  return error_.load( memory_order_acquire );
+}
+
+uint64_t SPSCByteStream::bytes_buffered() const
+{
+  return pushed_.load( memory_order_acquire ) - popped_.load( memory_order_acquire );
+}
+
+uint64_t SPSCByteStream::bytes_popped() const
+{
+  return popped_.load( memory_order_acquire );
+}
+
+void SPSCByteStream::wait_readable()
+{
+  wait_until( readable_, [this] { return bytes_buffered() > 0 or is_closed() or has_error(); } );
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+// A ByteStream for one writer thread and one reader thread, without locks.
+//
+// The bytes go through a ring buffer. The writer copies bytes in and then publishes its new count of bytes
+// pushed with a release store, which the reader loads with acquire before reading them; the reader publishes
+// its count of bytes popped the same way before the writer reuses the space. Each side keeps its own count,
+// and its last look at the other side's, on a cache line of its own, so the threads only pull in each other's
+// line when one of them seems to have run out of data or of room.
+//
+// Either side can sleep until the other makes progress (wait_readable(), wait_writable()). Sleeping is done
+// on a futex, and the side making progress only makes the system call to wake it when it is asleep.
+class SPSCByteStream
+{
+  static constexpr size_t CACHE_LINE = 64;
+
+  // A futex word to sleep on, and whether a thread is (about to be) asleep on it
+  struct alignas( CACHE_LINE ) Wakeup
+  {
+    std::atomic<uint32_t> sequence {};
+    std::atomic<bool> waiting {};
+  };
+
+  uint64_t capacity_;
+  uint64_t mask_; // the ring's size (the capacity rounded up to a power of two), minus one
+  std::unique_ptr<char[]> ring_;
+
+  // Written by the writer
+  alignas( CACHE_LINE ) std::atomic<uint64_t> pushed_ {};
+  std::atomic<bool> closed_ {};
+  std::atomic<bool> error_ {};
+  uint64_t popped_seen_ {}; // the writer's last look at popped_
+
+  // Written by the reader
+  alignas( CACHE_LINE ) std::atomic<uint64_t> popped_ {};
+  mutable uint64_t pushed_seen_ {}; // the reader's last look at pushed_
+
+  Wakeup readable_ {}; // the reader sleeps here until there is data, or the stream has ended
+  Wakeup writable_ {}; // the writer sleeps here until there is room
+
+  static void wake( Wakeup& wakeup );
+  template<typename Ready>
+  static void wait_until( Wakeup& wakeup, Ready&& ready );
+
+public:
+  explicit SPSCByteStream( uint64_t capacity );
+
+  SPSCByteStream( const SPSCByteStream& other ) = delete;
+  SPSCByteStream& operator=( const SPSCByteStream& other ) = delete;
+  ~SPSCByteStream() = default;
+
+  uint64_t capacity() const { return capacity_; }
+
+  // For the writer
+  uint64_t push( std::string_view data ); // Push as much of `data` as there is room for; returns how much that was
+  void close();                           // Nothing more will be written
+  void set_error();                       // The stream suffered an error
+  bool is_closed() const;
+  uint64_t available_capacity() const;
+  uint64_t bytes_pushed() const;
+  void wait_writable(); // Sleep until there is room to push, or the stream has an error
+
+  // For the reader
+  std::string_view peek() const; // The next bytes in the buffer (up to the end of the ring)
+  void pop( uint64_t len );
+  bool is_finished() const; // Closed, and everything popped
+  bool has_error() const;
+  uint64_t bytes_buffered() const;
+  uint64_t bytes_popped() const;
+  void wait_readable(); // Sleep until there is something to peek, or the stream has finished or has an error
+};
@@ -0,0 +1,93 @@
+#include "tcp_peer.hh"
+
+#include <algorithm>
+#include <utility>
+
+using namespace std;
+
+TCPPeer::TCPPeer( const TCPConfig& cfg )
+  : cfg_( cfg )
+  , outbound_stream_( cfg.send_capacity )
+  , inbound_stream_( cfg.recv_capacity )
+  , sender_( cfg.rt_timeout, cfg.fixed_isn )
+{}
+
+void TCPPeer::push()
+{
+  if ( outbound_stream_.reader().bytes_buffered() > 0 ) {
+    idle_ms_ = 0;
+    compacted_ = false;
+  }
+  sender_.push( outbound_stream_.reader() );
+}
+
+void TCPPeer::receive( TCPMessage message )
+{
+  idle_ms_ = 0;
+  compacted_ = false;
+
+  // Anything that occupies sequence space must be acknowledged, even if it was a duplicate
+  if ( message.sender.sequence_length() > 0 ) {
+    ack_owed_ = true;
+  }
+
+  receiver_.receive( move( message.sender ), reassembler_, inbound_stream_.writer() );
+  sender_.receive( message.receiver );
+
+  // An acknowledgment or a wider window may let more data out
+  push();
+}
+
+void TCPPeer::tick( uint64_t ms_since_last_tick )
+{
+  sender_.tick( ms_since_last_tick );
+
+  // Compact as the connection crosses the idle threshold, and then on every tick until everything has been
+  // released: the application may read the last of the inbound stream long after the connection went quiet
+  idle_ms_ += ms_since_last_tick;
+  const uint64_t threshold = cfg_.idle_compact_ms;
+  if ( threshold > 0 and idle_ms_ >= threshold and not compacted_ ) {
+    compacted_ = compact();
+  }
+}
+
+bool TCPPeer::compact()
+{
+  const bool outbound = outbound_stream_.compact();
+  const bool inbound = inbound_stream_.compact();
+  const bool reassembly = reassembler_.compact();
+  return outbound and inbound and reassembly;
+}
+
+// Following RFC 1122's receiver-side silly window avoidance: once the application has read enough to open
+// the window by a full segment (or half the buffer), tell the sender, which may otherwise be stuck probing
+// a window it believes is shut
+bool TCPPeer::window_update_owed() const
+{
+  const TCPReceiverMessage current = receiver_message();
+  const uint64_t threshold = min( TCPConfig::MAX_PAYLOAD_SIZE, cfg_.recv_capacity / 2 );
+  return current.ackno.has_value() and current.window_size >= window_advertised_ + threshold;
+}
+
+optional<TCPMessage> TCPPeer::maybe_send()
+{
+  optional<TCPSenderMessage> segment = sender_.maybe_send();
+  if ( not segment.has_value() ) {
+    if ( not ack_owed_ and not window_update_owed() ) {
+      return nullopt;
+    }
+    segment = sender_.send_empty_message();
+  }
+
+  TCPMessage message { move( *segment ), receiver_message() };
+  ack_owed_ = false;
+  window_advertised_ = message.receiver.window_size;
+  return message;
+}
+
+bool TCPPeer::active() const
+{
+  const bool outbound_done = outbound_stream_.reader().is_finished() and sender_.sequence_numbers_in_flight() == 0;
+  const bool inbound_done = inbound_stream_.reader().is_finished();
+  return not( outbound_done and inbound_done ) or ack_owed_;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "byte_stream.hh"
+#include "reassembler.hh"
+#include "tcp_config.hh"
+#include "tcp_message.hh"
+#include "tcp_receiver.hh"
+#include "tcp_sender.hh"
+
+#include <cstdint>
+#include <optional>
+
+/*
+ * One end of a full-duplex TCP connection: a TCPSender and a TCPReceiver, the ByteStreams they carry,
+ * and the Reassembler in between.
+ *
+ * Every outgoing segment carries the receiver's current ackno and window, so data flowing one way
+ * acknowledges data flowing the other. A segment with no data of its own is only sent when an
+ * acknowledgment or window update is owed and there is nothing to carry it.
+ *
+ * A connection that has been idle for cfg.idle_compact_ms compacts itself, releasing the buffers that
+ * have nothing in them; they are allocated again as soon as they are needed. Buffers still holding data
+ * then (say, unread by a slow application) are released on a later tick, once they have been emptied.
+ */
+class TCPPeer
+{
+  TCPConfig cfg_;
+  ByteStream outbound_stream_;
+  ByteStream inbound_stream_;
+  TCPSender sender_;
+  TCPReceiver receiver_ {};
+  Reassembler reassembler_ {};
+
+  bool ack_owed_ {};              // received sequence space that has not been acknowledged yet
+  uint64_t window_advertised_ {}; // the window in the last segment sent
+  uint64_t idle_ms_ {};           // time since the last segment was received or data pushed
+  bool compacted_ {};             // every buffer released since the connection went idle
+
+  TCPReceiverMessage receiver_message() const { return receiver_.send( inbound_stream_.writer() ); }
+  bool window_update_owed() const;
+
+public:
+  explicit TCPPeer( const TCPConfig& cfg );
+
+  /* The application writes to the outbound stream and reads from the inbound one */
+  Writer& outbound_writer() { return outbound_stream_.writer(); }
+  Reader& inbound_reader() { return inbound_stream_.reader(); }
+  const Reader& inbound_reader() const { return inbound_stream_.reader(); }
+
+  /* Take what the window allows from the outbound stream (and the SYN or FIN, when due) into segments */
+  void push();
+
+  /* Handle a segment from the other peer: its payload for the inbound stream, its ackno and window for the
+   * sender (which may then push more) */
+  void receive( TCPMessage message );
+
+  /* Time has passed by the given # of milliseconds since the last time the tick() method was called */
+  void tick( uint64_t ms_since_last_tick );
+
+  /* The next segment to send, if any: data, a retransmission, or an acknowledgment or window update */
+  std::optional<TCPMessage> maybe_send();
+
+  /* Release the memory of every empty buffer (the streams' and the reassembler's), leaving only the
+   * connection's control state. Safe at any time; what is still in use is kept. Returns whether every
+   * buffer is now released. */
+  bool compact();
+
+  /* Has the connection still got work to do (data or a FIN, in either direction, not yet acknowledged)? */
+  bool active() const;
+};
@@ -1,4 +1,5 @@
 #include "tcp_sender.hh"
+#include "retransmission_timers.hh"
 #include "tcp_config.hh"
 #include "tcp_sender_message.hh"
 #include "wrapping_integers.hh"
@@ -6,6 +7,7 @@
 #include <cstdint>
 #include <optional>
 #include <random>
+#include <utility>
 
 using namespace std;
 
@@ -24,6 +26,69 @@ TCPSender::TCPSender( uint64_t initial_RTO_ms, optional<Wrap32> fixed_isn )
   timer_.RTO = initial_RTO_ms;
 }
 
+TCPSender::TCPSender( TCPSender&& other ) noexcept
+  : isn_( other.isn_ )
+  , initial_RTO_ms_( other.initial_RTO_ms_ )
+  , cur_ackno_( other.cur_ackno_ )
+  , cur_window_( other.cur_window_ )
+  , in_flight_seqnos_( other.in_flight_seqnos_ )
+  , n_retrans_( other.n_retrans_ )
+  , finished_( other.finished_ )
+  , timer_( other.timer_ )
+  , seqno_to_msg_( move( other.seqno_to_msg_ ) )
+  , timers_( exchange( other.timers_, nullptr ) )
+  , timer_id_( other.timer_id_ )
+{
+  if ( timers_ ) {
+    timers_->wheel_.value( timer_id_ ) = this;
+  }
+}
+
+TCPSender& TCPSender::operator=( TCPSender&& other ) noexcept
+{
+  if ( this != &other ) {
+    leave_timers();
+    isn_ = other.isn_;
+    initial_RTO_ms_ = other.initial_RTO_ms_;
+    cur_ackno_ = other.cur_ackno_;
+    cur_window_ = other.cur_window_;
+    in_flight_seqnos_ = other.in_flight_seqnos_;
+    n_retrans_ = other.n_retrans_;
+    finished_ = other.finished_;
+    timer_ = other.timer_;
+    seqno_to_msg_ = move( other.seqno_to_msg_ );
+    timers_ = exchange( other.timers_, nullptr );
+    timer_id_ = other.timer_id_;
+    if ( timers_ ) {
+      timers_->wheel_.value( timer_id_ ) = this;
+    }
+  }
+  return *this;
+}
+
+TCPSender::~TCPSender()
+{
+  leave_timers();
+}
+
+void TCPSender::use_timers( RetransmissionTimers& timers )
+{
+  leave_timers();
+  timers_ = &timers;
+  timer_id_ = timers.wheel_.create( this );
+  if ( timer_.running ) {
+    timers.wheel_.schedule_in( timer_id_, timer_.RTO - min( timer_.current_time, timer_.RTO ) );
+  }
+}
+
+void TCPSender::leave_timers()
+{
+  if ( timers_ ) {
+    timers_->wheel_.destroy( timer_id_ );
+    timers_ = nullptr;
+  }
+}
+
 uint64_t TCPSender::sequence_numbers_in_flight() const
 {
   if ( seqno_to_msg_.empty() )
@@ -85,15 +150,19 @@ void TCPSender::push( Reader& outbound_stream )
     if ( msg_length == 0 )
       break;
 
-    string payload = gen_payload( outbound_stream, msg_length - SYN );
+    InternetChecksum checksum;
+    Buffer payload = gen_payload( outbound_stream, msg_length - SYN, checksum );
 
     // If stream has been closed after popping and there is still one more available space for FIN ,
     // then we insert FIN
     bool FIN = outbound_stream.is_finished() && remaining - msg_length >= 1;
     if ( FIN )
       finished_ = true;
-    TCPSenderMessage msg
-      = TCPSenderMessage { .seqno = Wrap32::wrap( cur_ackno_, isn_ ), .SYN = SYN, .payload = payload, .FIN = FIN };
+    TCPSenderMessage msg = TCPSenderMessage { .seqno = Wrap32::wrap( cur_ackno_, isn_ ),
+                                              .SYN = SYN,
+                                              .payload = move( payload ),
+                                              .FIN = FIN,
+                                              .payload_sum = checksum.sum() };
     msg_length += FIN;
 
     seqno_to_msg_[cur_ackno_] = MsgWithFlag { .msg = msg, .sent = false };
@@ -143,35 +212,50 @@ void TCPSender::receive( const TCPReceiverMessage& msg )
 
 void TCPSender::tick( const size_t ms_since_last_tick )
 {
+  // Time comes from the RetransmissionTimers instead
+  if ( timers_ )
+    return;
+
   if ( timer_.running ) {
     timer_.current_time += ms_since_last_tick;
   }
 
-  if ( timer_.current_time >= timer_.RTO ) {
-    // Retransmit the earliest (lowest sequence number) segment that hasn’t been fully acknowledged
-    if ( !seqno_to_msg_.empty() )
-      seqno_to_msg_.begin()->second.sent = false;
-
-    if ( cur_window_ != 0 ) {
-      // Keep track of consecutive retransmissions
-      n_retrans_++;
-      // Double RTO, "exponential backof"
-      timer_.RTO *= 2;
-    }
+  // A stopped timer cannot expire, even if it had run past the (since reset) RTO before it was stopped
+  if ( timer_.running and timer_.current_time >= timer_.RTO ) {
+    expire();
+  }
+}
 
-    //  Reset timer and start it
-    stopTimer();
-    startTimer();
+void TCPSender::expire()
+{
+  // Retransmit the earliest (lowest sequence number) segment that hasn’t been fully acknowledged
+  if ( !seqno_to_msg_.empty() )
+    seqno_to_msg_.begin()->second.sent = false;
+
+  if ( cur_window_ != 0 ) {
+    // Keep track of consecutive retransmissions
+    n_retrans_++;
+    // Double RTO, "exponential backof"
+    timer_.RTO *= 2;
   }
+
+  //  Reset timer and start it
+  stopTimer();
+  startTimer();
 }
 
-string TCPSender::gen_payload( Reader& outbound_stream, uint64_t payload_length )
+// Copy the payload out of the stream, summing it for the segment checksum as it is copied. The payload
+// gets a pooled Buffer of its own (none at all, for a SYN or FIN alone). It has no headroom: it is kept for
+// retransmission, so it is never unique and headers could not be prepended to it.
+Buffer TCPSender::gen_payload( Reader& outbound_stream, uint64_t payload_length, InternetChecksum& checksum )
 {
-  string payload;
-  // NOTE: Such approach is inefficient but general for all kinds of bytestream
-  while ( payload.size() < payload_length ) {
-    string peeked = string( outbound_stream.peek().substr( 0, payload_length - payload.size() ) );
-    payload.append( peeked );
+  Buffer payload = Buffer::uninitialized( payload_length );
+  uint64_t copied = 0;
+  // peek() may return less than is buffered, so keep going until the payload is full
+  while ( copied < payload_length ) {
+    const string_view peeked = outbound_stream.peek().substr( 0, payload_length - copied );
+    checksum.add_copy( payload.mutable_data() + copied, peeked );
+    copied += peeked.size();
     outbound_stream.pop( peeked.size() );
   }
   return payload;
@@ -181,9 +265,13 @@ void TCPSender::startTimer()
 {
   timer_.running = true;
   timer_.current_time = 0;
+  if ( timers_ )
+    timers_->wheel_.schedule_in( timer_id_, timer_.RTO );
 }
 
 void TCPSender::stopTimer()
 {
   timer_.running = false;
+  if ( timers_ )
+    timers_->wheel_.cancel( timer_id_ );
 }
@@ -1,11 +1,14 @@
 #pragma once
 
 #include "byte_stream.hh"
+#include "checksum.hh"
 #include "tcp_receiver_message.hh"
 #include "tcp_sender_message.hh"
 #include <cstdint>
 #include <map>
 
+class RetransmissionTimers;
+
 struct MsgWithFlag
 {
   TCPSenderMessage msg = {};
@@ -21,6 +24,8 @@ struct Timer
 
 class TCPSender
 {
+  friend class RetransmissionTimers;
+
   Wrap32 isn_;
   uint64_t initial_RTO_ms_;
   uint64_t cur_ackno_;
@@ -31,11 +36,24 @@ class TCPSender
   bool finished_;
   Timer timer_;
   std::map<uint64_t, MsgWithFlag> seqno_to_msg_;
+  RetransmissionTimers* timers_ {}; // keeps time for timer_ instead of tick(), if set
+  uint32_t timer_id_ {};
 
 public:
   /* Construct TCP sender with given default Retransmission Timeout and possible ISN */
   TCPSender( uint64_t initial_RTO_ms, std::optional<Wrap32> fixed_isn );
 
+  /* A sender in a RetransmissionTimers moves its timer there along with it */
+  TCPSender( TCPSender&& other ) noexcept;
+  TCPSender& operator=( TCPSender&& other ) noexcept;
+  TCPSender( const TCPSender& other ) = delete;
+  TCPSender& operator=( const TCPSender& other ) = delete;
+  ~TCPSender();
+
+  /* Run the retransmission timer in a shared RetransmissionTimers, which must outlive the sender, from now on.
+   * tick() then does nothing. */
+  void use_timers( RetransmissionTimers& timers );
+
   /* Push bytes from the outbound stream */
   void push( Reader& outbound_stream );
 
@@ -55,8 +73,10 @@ public:
   uint64_t sequence_numbers_in_flight() const;  // How many sequence numbers are outstanding?
   uint64_t consecutive_retransmissions() const; // How many consecutive *re*transmissions have happened?
 private:
-  std::string gen_payload( Reader& outbound_stream, uint64_t payload_length );
+  Buffer gen_payload( Reader& outbound_stream, uint64_t payload_length, InternetChecksum& checksum );
 
   void startTimer();
   void stopTimer();
+  void expire(); // the retransmission timer has run out
+  void leave_timers();
 };
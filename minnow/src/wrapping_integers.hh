@@ -28,6 +28,9 @@ public:
    */
   uint64_t unwrap( Wrap32 zero_point, uint64_t checkpoint ) const;
 
+  /* The 32-bit value itself, as carried in a TCP header */
+  uint32_t raw_value() const { return raw_value_; }
+
   Wrap32 operator+( uint32_t n ) const { return Wrap32 { raw_value_ + n }; }
   bool operator==( const Wrap32& other ) const { return raw_value_ == other.raw_value_; }
 };
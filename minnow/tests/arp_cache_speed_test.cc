@@ -0,0 +1,107 @@
+#include "flat_hash_map.hh"
+#include "network_interface.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+
+constexpr size_t n_lookups = 1 << 22;
+
+// Time `n_lookups` lookups of random cached addresses; returns millions of lookups per second
+template<typename F>
+double time_lookups( const vector<uint32_t>& probes, F&& lookup )
+{
+  uint64_t checksum = 0;
+  const auto start_time = steady_clock::now();
+  for ( const uint32_t ip : probes ) {
+    checksum += lookup( ip );
+  }
+  const auto stop_time = steady_clock::now();
+
+  if ( checksum == 0 ) {
+    throw runtime_error( "lookups found nothing" );
+  }
+  const auto test_duration = duration_cast<duration<double, micro>>( stop_time - start_time );
+  return static_cast<double>( probes.size() ) / test_duration.count();
+}
+
+} // namespace
+
+void speed_test( const size_t n_entries, const size_t random_seed ) // NOLINT(bugprone-easily-swappable-parameters)
+{
+  default_random_engine rd { random_seed };
+  vector<uint32_t> ips( n_entries );
+  for ( auto& ip : ips ) {
+    ip = static_cast<uint32_t>( rd() );
+  }
+  vector<uint32_t> probes( n_lookups );
+  uniform_int_distribution<size_t> pick { 0, n_entries - 1 };
+  for ( auto& ip : probes ) {
+    ip = ips[pick( rd )];
+  }
+
+  // The cache as two node-based maps (the previous layout)
+  unordered_map<uint32_t, EthernetAddress> ip_to_ethernet;
+  unordered_map<uint32_t, size_t> ip_to_time;
+  // The cache as one flat table
+  FlatHashMap<uint32_t, NetworkInterface::ARPEntry> cache;
+
+  for ( const uint32_t ip : ips ) {
+    const EthernetAddress eth { 2, 0, 0, 0, static_cast<uint8_t>( ip >> 8 ), static_cast<uint8_t>( ip | 1 ) };
+    ip_to_ethernet[ip] = eth;
+    ip_to_time[ip] = ip;
+    auto& entry = cache[ip];
+    entry.ethernet_address = eth;
+    entry.state = NetworkInterface::ARPEntry::State::REACHABLE;
+    entry.updated_ms = ip;
+  }
+
+  const double maps_rate = time_lookups( probes, [&]( uint32_t ip ) -> uint64_t {
+    const auto eth = ip_to_ethernet.find( ip );
+    const auto time = ip_to_time.find( ip );
+    return eth->second.back() + ( time->second & 1 );
+  } );
+
+  const double flat_rate = time_lookups( probes, [&]( uint32_t ip ) -> uint64_t {
+    const auto* entry = cache.find( ip );
+    return entry->ethernet_address.back() + ( entry->updated_ms & 1 );
+  } );
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "ARP cache with " << n_entries << " entries: two unordered_maps " << fixed << setprecision( 1 )
+       << maps_rate << " M lookups/s, FlatHashMap " << flat_rate << " M lookups/s.\n";
+
+  debug_output << "      ARP cache lookups (" << n_entries << " entries): " << fixed << setprecision( 1 )
+               << flat_rate << " M/s (was " << maps_rate << " M/s)\n";
+}
+
+void program_body()
+{
+  speed_test( 1000, 1 );
+  speed_test( 100000, 2 );
+  speed_test( 1000000, 3 );
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -1,4 +1,5 @@
 #include "byte_stream.hh"
+#include "spsc_byte_stream.hh"
 
 #include <chrono>
 #include <cstddef>
@@ -7,6 +8,7 @@
 #include <iostream>
 #include <queue>
 #include <random>
+#include <thread>
 
 using namespace std;
 using namespace std::chrono;
@@ -86,9 +88,112 @@ void speed_test( const size_t input_len,   // NOLINT(bugprone-easily-swappable-p
   }
 }
 
+// The same data through an SPSCByteStream, written by one thread and read by another, each of which sleeps
+// when it runs out of room or of data
+void threaded_speed_test( const size_t input_len,  // NOLINT(bugprone-easily-swappable-parameters)
+                          const size_t capacity,   // NOLINT(bugprone-easily-swappable-parameters)
+                          const size_t write_size, // NOLINT(bugprone-easily-swappable-parameters)
+                          const size_t read_size ) // NOLINT(bugprone-easily-swappable-parameters)
+{
+  string data( input_len, 0 );
+  for ( size_t i = 0; i < input_len; i++ ) {
+    data[i] = static_cast<char>( i * 7 + i / 251 );
+  }
+
+  SPSCByteStream bs { capacity };
+  string output_data;
+  output_data.reserve( data.size() );
+
+  const auto start_time = steady_clock::now();
+  thread writer( [&] {
+    for ( size_t i = 0; i < data.size(); i += write_size ) {
+      string_view chunk = string_view { data }.substr( i, write_size );
+      while ( not chunk.empty() ) {
+        const uint64_t pushed = bs.push( chunk );
+        chunk.remove_prefix( pushed );
+        if ( pushed == 0 ) {
+          bs.wait_writable();
+        }
+      }
+    }
+    bs.close();
+  } );
+
+  while ( true ) {
+    bs.wait_readable();
+    if ( bs.is_finished() ) {
+      break;
+    }
+    const string_view peeked = bs.peek().substr( 0, read_size );
+    output_data += peeked;
+    bs.pop( peeked.size() );
+  }
+  writer.join();
+  const auto stop_time = steady_clock::now();
+
+  if ( data != output_data ) {
+    throw runtime_error( "Mismatch between data written and read (SPSCByteStream)" );
+  }
+
+  const double seconds = duration_cast<duration<double>>( stop_time - start_time ).count();
+  const double gigabits_per_second = 8 * static_cast<double>( input_len ) / seconds / 1e9;
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "SPSCByteStream between two threads with capacity=" << capacity << ", write_size=" << write_size
+       << ", read_size=" << read_size << " reached " << fixed << setprecision( 2 ) << gigabits_per_second
+       << " Gbit/s.\n";
+
+  debug_output << "  SPSCByteStream (2 threads) throughput: " << fixed << setprecision( 2 ) << gigabits_per_second
+               << " Gbit/s\n";
+}
+
+// Bounce a byte back and forth between two threads through a pair of SPSCByteStreams, with each thread
+// asleep until the byte reaches it; half the round trip is the time to wake the other side
+void wakeup_latency_test( const size_t round_trips )
+{
+  SPSCByteStream ping { 1 };
+  SPSCByteStream pong { 1 };
+
+  // Wait for a byte, and take it
+  const auto receive = []( SPSCByteStream& bs ) {
+    bs.wait_readable();
+    bs.pop( bs.peek().size() );
+  };
+
+  thread echo( [&] {
+    for ( size_t i = 0; i < round_trips; i++ ) {
+      receive( ping );
+      pong.push( "x" );
+    }
+  } );
+
+  const auto start_time = steady_clock::now();
+  for ( size_t i = 0; i < round_trips; i++ ) {
+    ping.push( "x" );
+    receive( pong );
+  }
+  const auto stop_time = steady_clock::now();
+  echo.join();
+
+  const double wakeup_us
+    = duration_cast<duration<double, micro>>( stop_time - start_time ).count() / ( 2 * round_trips );
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "SPSCByteStream wakeup latency (" << round_trips << " round trips between two threads): " << fixed
+       << setprecision( 2 ) << wakeup_us << " us.\n";
+
+  debug_output << "     SPSCByteStream wakeup latency: " << fixed << setprecision( 2 ) << wakeup_us << " us\n";
+}
+
 void program_body()
 {
   speed_test( 1e7, 32768, 789, 1500, 128 );
+  threaded_speed_test( 1e8, 32768, 1500, 16384 );
+  wakeup_latency_test( 20'000 );
 }
 
 int main()
@@ -0,0 +1,133 @@
+#include "checksum.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+
+// The byte-at-a-time algorithm, as a reference
+uint16_t reference_checksum( const vector<Buffer>& fragments )
+{
+  uint32_t sum = 0;
+  bool parity = false;
+  for ( const auto& fragment : fragments ) {
+    for ( const uint8_t c : string_view { fragment } ) {
+      sum += parity ? c : c << 8;
+      parity = !parity;
+    }
+  }
+  while ( sum > 0xffff ) {
+    sum = ( sum >> 16 ) + static_cast<uint16_t>( sum );
+  }
+  return ~sum;
+}
+
+string random_string( default_random_engine& rd, size_t len )
+{
+  uniform_int_distribution<char> ud;
+  string ret( len, 0 );
+  for ( auto& c : ret ) {
+    c = ud( rd );
+  }
+  return ret;
+}
+
+// Compare against the reference on inputs split into fragments of random (often odd) lengths
+void check_correctness( default_random_engine& rd )
+{
+  for ( size_t trial = 0; trial < 2000; trial++ ) {
+    const size_t max_len = trial < 1000 ? 300 : 5000;
+    const size_t len = uniform_int_distribution<size_t> { 0, max_len }( rd );
+    const string data = random_string( rd, len );
+
+    vector<Buffer> fragments;
+    for ( size_t i = 0; i < len; ) {
+      const size_t n = min( len - i, uniform_int_distribution<size_t> { 0, 700 }( rd ) );
+      fragments.emplace_back( data.substr( i, n ) );
+      i += n;
+    }
+
+    InternetChecksum check;
+    check.add( fragments );
+    if ( check.value() != reference_checksum( fragments ) ) {
+      throw runtime_error( "InternetChecksum disagrees with the reference on " + to_string( len ) + " bytes" );
+    }
+  }
+}
+
+} // namespace
+
+void speed_test( const size_t input_len, const size_t random_seed ) // NOLINT(bugprone-easily-swappable-parameters)
+{
+  default_random_engine rd { random_seed };
+  vector<Buffer> data { random_string( rd, input_len ) };
+  char* input = data.front().mutable_data(); // the only reference, so it may be written
+  const size_t n_iterations = max( size_t { 1 }, ( size_t { 1 } << 30 ) / input_len );
+
+  uint32_t sink = 0;
+  const auto start_time = steady_clock::now();
+  for ( size_t i = 0; i < n_iterations; i++ ) {
+    input[i % input_len]++; // keep the compiler from hoisting the work out of the loop
+    InternetChecksum check;
+    check.add( data );
+    sink += check.value();
+  }
+  const auto stop_time = steady_clock::now();
+
+  // The byte-at-a-time version, on a sixteenth of the data
+  const auto reference_start = steady_clock::now();
+  for ( size_t i = 0; i < n_iterations / 16; i++ ) {
+    input[i % input_len]++;
+    sink += reference_checksum( data );
+  }
+  const auto reference_stop = steady_clock::now();
+
+  if ( sink == 0 ) {
+    throw runtime_error( "unlikely checksum total" );
+  }
+
+  const auto bytes = static_cast<double>( n_iterations * input_len );
+  const double gbps = bytes / duration_cast<duration<double, nano>>( stop_time - start_time ).count();
+  const double reference_gbps
+    = bytes / 16 / duration_cast<duration<double, nano>>( reference_stop - reference_start ).count();
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "InternetChecksum over " << input_len << "-byte inputs: " << fixed << setprecision( 2 ) << gbps
+       << " GB/s (byte-at-a-time: " << reference_gbps << " GB/s).\n";
+
+  debug_output << "      InternetChecksum throughput (" << input_len << " B): " << fixed << setprecision( 2 )
+               << gbps << " GB/s\n";
+}
+
+void program_body()
+{
+  default_random_engine rd { 1 };
+  check_correctness( rd );
+
+  speed_test( 64, 2 );
+  speed_test( 1500, 3 );
+  speed_test( 65536, 4 );
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,146 @@
+#include "connection_table.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+constexpr uint32_t server_ip = 0x0a000001; // 10.0.0.1
+constexpr uint16_t server_port = 80;
+
+void expect( bool condition, const string& what )
+{
+  if ( not condition ) {
+    throw runtime_error( "ConnectionTable: expected " + what );
+  }
+}
+
+// The 4-tuple of a client's connection to the server, from the server's side
+FourTuple client( uint16_t port )
+{
+  return { server_ip, 0x0a000002, server_port, port };
+}
+
+TCPSegment segment_from( const FourTuple& tuple )
+{
+  TCPSegment segment;
+  segment.src_port = tuple.remote_port;
+  segment.dst_port = tuple.local_port;
+  segment.message.sender.seqno = Wrap32 { 1000 };
+  return segment;
+}
+
+TCPSegment syn_from( const FourTuple& tuple )
+{
+  TCPSegment syn = segment_from( tuple );
+  syn.message.sender.SYN = true;
+  return syn;
+}
+
+optional<ConnectionTable::ConnectionId> deliver( ConnectionTable& table,
+                                                 const FourTuple& tuple,
+                                                 TCPSegment&& segment )
+{
+  return table.receive( tuple.remote_ip, tuple.local_ip, move( segment ) );
+}
+
+void remove_before_accept()
+{
+  ConnectionTable table;
+  table.listen( server_ip, server_port, 2 );
+
+  const auto first = deliver( table, client( 1000 ), syn_from( client( 1000 ) ) );
+  expect( first.has_value(), "a SYN to a listening port to start a connection" );
+  table.remove( *first );
+  expect( table.size() == 0, "the removed connection to be gone" );
+  expect( not table.accept( server_ip, server_port ).has_value(), "nothing to accept after the removal" );
+
+  // Its id is reused by the next connection, which is accepted once, under its own tuple
+  const auto second = deliver( table, client( 1001 ), syn_from( client( 1001 ) ) );
+  expect( second == first, "the freed id to be reused" );
+  const auto accepted = table.accept( server_ip, server_port );
+  expect( accepted == second, "the new connection to be accepted" );
+  expect( table.connection( *accepted ).tuple == client( 1001 ), "the accepted connection's own tuple" );
+  expect( not table.accept( server_ip, server_port ).has_value(), "the reused id to be accepted only once" );
+
+  // A removed connection leaves room in the backlog
+  const auto third = deliver( table, client( 1002 ), syn_from( client( 1002 ) ) );
+  const auto fourth = deliver( table, client( 1003 ), syn_from( client( 1003 ) ) );
+  expect( third.has_value() and fourth.has_value(), "two SYNs to fill the backlog" );
+  expect( not deliver( table, client( 1004 ), syn_from( client( 1004 ) ) ), "a full backlog" );
+  table.remove( *third );
+  expect( deliver( table, client( 1004 ), syn_from( client( 1004 ) ) ).has_value(),
+          "room in the backlog after a removal" );
+  expect( table.accept( server_ip, server_port ) == fourth, "the oldest remaining connection first" );
+}
+
+void backlog()
+{
+  ConnectionTable table;
+  table.listen( server_ip, server_port, 1 );
+
+  const auto first = deliver( table, client( 1000 ), syn_from( client( 1000 ) ) );
+  expect( first.has_value(), "a SYN to start a connection" );
+  expect( not deliver( table, client( 1001 ), syn_from( client( 1001 ) ) ),
+          "a SYN past the backlog to be dropped" );
+  expect( table.size() == 1, "no connection for the dropped SYN" );
+
+  // Segments for a connection already started still reach it
+  expect( deliver( table, client( 1000 ), segment_from( client( 1000 ) ) ) == first,
+          "a segment to reach its pending connection" );
+
+  expect( table.accept( server_ip, server_port ) == first, "the first connection to be accepted" );
+  expect( deliver( table, client( 1001 ), syn_from( client( 1001 ) ) ).has_value(),
+          "room in the backlog after an accept" );
+
+  ConnectionTable no_backlog;
+  no_backlog.listen( server_ip, server_port, 0 );
+  expect( not deliver( no_backlog, client( 1000 ), syn_from( client( 1000 ) ) ), "a backlog of 0 to refuse all" );
+}
+
+void dropped_at_listener()
+{
+  ConnectionTable table;
+  table.listen( server_ip, server_port, 8 );
+
+  TCPSegment ack = segment_from( client( 1000 ) );
+  ack.message.receiver.ackno = Wrap32 { 5 };
+  expect( not deliver( table, client( 1000 ), move( ack ) ), "a bare ACK to a listener to be dropped" );
+
+  TCPSegment data = segment_from( client( 1001 ) );
+  data.message.sender.payload = Buffer { "hello" };
+  expect( not deliver( table, client( 1001 ), move( data ) ), "data without a SYN to a listener to be dropped" );
+
+  TCPSegment syn_ack = syn_from( client( 1002 ) );
+  syn_ack.message.receiver.ackno = Wrap32 { 5 };
+  expect( not deliver( table, client( 1002 ), move( syn_ack ) ), "a SYN+ACK to a listener to be dropped" );
+
+  FourTuple elsewhere = client( 1003 );
+  elsewhere.local_port = server_port + 1;
+  expect( not deliver( table, elsewhere, syn_from( elsewhere ) ),
+          "a SYN to a port nobody listens on to be dropped" );
+
+  expect( table.size() == 0, "no connections" );
+  expect( not table.accept( server_ip, server_port ).has_value(), "nothing to accept" );
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    remove_before_accept();
+    backlog();
+    dropped_at_listener();
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
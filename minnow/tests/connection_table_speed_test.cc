@@ -0,0 +1,160 @@
+#include "connection_table.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <malloc.h>
+#include <new>
+#include <random>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+// Track the bytes the program has live on the heap
+namespace {
+size_t live_bytes = 0;
+
+// Kept out of line, so the compiler does not pair each inlined free() with the operator new it came from
+[[gnu::noinline]] void release( void* p )
+{
+  live_bytes -= malloc_usable_size( p );
+  free( p ); // NOLINT(*-no-malloc, *-owning-memory)
+}
+} // namespace
+
+void* operator new( size_t size )
+{
+  if ( void* p = malloc( size ) ) { // NOLINT(*-no-malloc, *-owning-memory)
+    live_bytes += malloc_usable_size( p );
+    return p;
+  }
+  throw bad_alloc();
+}
+
+void operator delete( void* p ) noexcept
+{
+  release( p );
+}
+
+void operator delete( void* p, size_t /* size */ ) noexcept
+{
+  release( p );
+}
+
+namespace {
+
+constexpr size_t n_connections = 100'000;
+constexpr size_t n_rounds = 5;
+constexpr uint32_t server_ip = 0x0a000001; // 10.0.0.1
+constexpr uint16_t server_port = 80;
+
+// The 4-tuple of the i'th client's connection to the server, from the server's side
+FourTuple client( size_t i )
+{
+  return { server_ip,
+           static_cast<uint32_t>( 0x0a010000 + i / 50'000 ),
+           server_port,
+           static_cast<uint16_t>( 10'000 + i % 50'000 ) };
+}
+
+// Time looking up each of `tuples` with `lookup`, in the given order; returns the best ns per lookup
+template<typename F>
+double time_lookups( const vector<FourTuple>& tuples, F&& lookup )
+{
+  double best = numeric_limits<double>::max();
+  for ( size_t round = 0; round < n_rounds; round++ ) {
+    size_t found = 0;
+    const auto start_time = steady_clock::now();
+    for ( const auto& tuple : tuples ) {
+      found += lookup( tuple );
+    }
+    const auto stop_time = steady_clock::now();
+    if ( found != n_connections ) {
+      throw runtime_error( "lookup lost a connection" );
+    }
+    best = min( best, duration_cast<duration<double, nano>>( stop_time - start_time ).count() / tuples.size() );
+  }
+  return best;
+}
+
+void speed_test()
+{
+  ConnectionTable table;
+  table.listen( server_ip, server_port, n_connections );
+
+  // Every client sends a SYN, which starts a connection, and the server accepts them all
+  const size_t bytes_before = live_bytes;
+  for ( size_t i = 0; i < n_connections; i++ ) {
+    const FourTuple tuple = client( i );
+    TCPSegment syn;
+    syn.src_port = tuple.remote_port;
+    syn.dst_port = tuple.local_port;
+    syn.message.sender.seqno = Wrap32 { static_cast<uint32_t>( i ) };
+    syn.message.sender.SYN = true;
+    if ( not table.receive( tuple.remote_ip, tuple.local_ip, move( syn ) ) ) {
+      throw runtime_error( "SYN was dropped" );
+    }
+  }
+  size_t accepted = 0;
+  while ( table.accept( server_ip, server_port ) ) {
+    accepted++;
+  }
+  if ( accepted != n_connections or table.size() != n_connections ) {
+    throw runtime_error( "connections went missing" );
+  }
+  const double bytes_per_connection = static_cast<double>( live_bytes - bytes_before ) / n_connections;
+
+  // Look every connection up, in an order unrelated to the one they were opened in
+  vector<FourTuple> tuples;
+  for ( size_t i = 0; i < n_connections; i++ ) {
+    tuples.push_back( client( i ) );
+  }
+  shuffle( tuples.begin(), tuples.end(), default_random_engine { 1 } );
+
+  const double table_ns
+    = time_lookups( tuples, [&]( const FourTuple& tuple ) { return table.find( tuple ).has_value(); } );
+
+  // And some that are not there: the same clients, on another port
+  vector<FourTuple> strangers = tuples;
+  for ( auto& tuple : strangers ) {
+    tuple.local_port++;
+  }
+  const double miss_ns
+    = time_lookups( strangers, [&]( const FourTuple& tuple ) { return not table.find( tuple ).has_value(); } );
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << n_connections << " idle connections: " << fixed << setprecision( 0 ) << bytes_per_connection
+       << " bytes of heap each; lookup by 4-tuple " << setprecision( 1 ) << table_ns << " ns (" << miss_ns
+       << " ns for a connection that is not there).\n";
+
+  debug_output << "      connection table (" << n_connections << " connections): " << fixed << setprecision( 1 )
+               << table_ns << " ns/lookup (miss: " << miss_ns << " ns), " << setprecision( 0 )
+               << bytes_per_connection << " B/connection\n";
+}
+
+} // namespace
+
+void program_body()
+{
+  speed_test();
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
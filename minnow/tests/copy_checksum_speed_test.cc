@@ -0,0 +1,103 @@
+#include "checksum.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+
+// Time `n_iterations` runs of `copy_and_sum( dst, src )` over `input`; returns GB/s
+template<typename F>
+double time_passes( string& input, string& output, size_t n_iterations, F&& copy_and_sum )
+{
+  uint32_t sink = 0;
+  const auto start_time = steady_clock::now();
+  for ( size_t i = 0; i < n_iterations; i++ ) {
+    input[i % input.size()]++; // keep the compiler from hoisting the work out of the loop
+    sink += copy_and_sum( output.data(), input );
+  }
+  const auto stop_time = steady_clock::now();
+
+  if ( sink == 0 or output != input ) {
+    throw runtime_error( "copy or checksum went wrong" );
+  }
+  const auto bytes = static_cast<double>( n_iterations * input.size() );
+  return bytes / duration_cast<duration<double, nano>>( stop_time - start_time ).count();
+}
+
+} // namespace
+
+void speed_test( const size_t input_len, const size_t random_seed ) // NOLINT(bugprone-easily-swappable-parameters)
+{
+  default_random_engine rd { random_seed };
+  uniform_int_distribution<char> ud;
+  string input( input_len, 0 );
+  for ( auto& c : input ) {
+    c = ud( rd );
+  }
+  string output( input_len, 0 );
+  const size_t n_iterations = max( size_t { 1 }, ( size_t { 1 } << 30 ) / input_len );
+
+  // Check the fused kernel against the two passes, with the input split at even and odd offsets
+  InternetChecksum separate;
+  separate.add( input );
+  for ( size_t split = 0; split < 8; split++ ) {
+    string copy( input_len, 0 );
+    InternetChecksum fused;
+    fused.add_copy( copy.data(), string_view { input }.substr( 0, split ) );
+    fused.add_copy( copy.data() + split, string_view { input }.substr( split ) );
+    if ( fused.value() != separate.value() or copy != input ) {
+      throw runtime_error( "InternetChecksum::add_copy disagrees with a copy and InternetChecksum::add" );
+    }
+  }
+
+  const double separate_rate = time_passes( input, output, n_iterations, []( char* dst, string_view src ) {
+    memcpy( dst, src.data(), src.size() );
+    InternetChecksum check;
+    check.add( string_view { dst, src.size() } );
+    return check.value();
+  } );
+
+  const double fused_rate = time_passes( input, output, n_iterations, []( char* dst, string_view src ) {
+    InternetChecksum check;
+    check.add_copy( dst, src );
+    return check.value();
+  } );
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "Copy and checksum of " << input_len << "-byte payloads: " << fixed << setprecision( 2 ) << fused_rate
+       << " GB/s fused, " << separate_rate << " GB/s as a copy then a checksum.\n";
+
+  debug_output << "      copy_and_checksum throughput (" << input_len << " B): " << fixed << setprecision( 2 )
+               << fused_rate << " GB/s (separate passes: " << separate_rate << " GB/s)\n";
+}
+
+void program_body()
+{
+  speed_test( 64, 1 );
+  speed_test( 1500, 2 );
+  speed_test( 65536, 3 );
+  speed_test( 1 << 22, 4 );
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
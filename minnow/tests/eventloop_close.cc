@@ -0,0 +1,99 @@
+#include "eventloop.hh"
+#include "socket.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+
+void expect( bool condition, const string& what )
+{
+  if ( not condition ) {
+    throw runtime_error( "EventLoop: expected " + what );
+  }
+}
+
+// Wait until the loop has nothing left to run, or give up after `max_waits` waits
+EventLoop::Result run( EventLoop& loop, size_t max_waits )
+{
+  EventLoop::Result result = EventLoop::Result::Success;
+  for ( size_t i = 0; i < max_waits and result != EventLoop::Result::Exit; i++ ) {
+    result = loop.wait_next_event( 100 );
+  }
+  return result;
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    {
+      // A socket closed from a timer (not from its own rule's callback) still has its rule cancelled
+      EventLoop loop;
+      UDPSocket socket;
+      socket.bind( Address { "127.0.0.1" } );
+      bool called = false;
+      bool cancelled = false;
+      loop.add_rule(
+        socket, EventLoop::Direction::In, [&] { called = true; }, {}, [&] { cancelled = true; } );
+      loop.add_timer( milliseconds { 1 }, [&] { socket.close(); } );
+
+      expect( run( loop, 10 ) == EventLoop::Result::Exit, "the loop to exit once the socket was closed" );
+      expect( cancelled, "the closed socket's rule to be cancelled" );
+      expect( not called, "no callback on a socket that never became readable" );
+    }
+
+    {
+      // A parked rule (not in the epoll set) is cancelled as well
+      EventLoop loop;
+      UDPSocket socket;
+      bool cancelled = false;
+      loop.add_rule(
+        socket, EventLoop::Direction::Out, [] {}, [] { return false; }, [&] { cancelled = true; } );
+      socket.close();
+
+      expect( run( loop, 10 ) == EventLoop::Result::Exit, "the loop to exit once the parked socket was closed" );
+      expect( cancelled, "the parked socket's rule to be cancelled" );
+    }
+
+    {
+      // A new descriptor that reuses a closed one's number can be watched before the loop waits again
+      EventLoop loop;
+      UDPSocket first;
+      bool first_cancelled = false;
+      loop.add_rule(
+        first, EventLoop::Direction::In, [] {}, {}, [&] { first_cancelled = true; } );
+      const int fd_num = first.fd_num();
+      first.close();
+
+      UDPSocket second;
+      expect( second.fd_num() == fd_num, "the lowest free descriptor number to be reused" );
+      second.bind( Address { "127.0.0.1" } );
+      bool second_called = false;
+      Address source { "0.0.0.0" };
+      string payload;
+      loop.add_rule( second, EventLoop::Direction::In, [&] {
+        second.recv( source, payload );
+        second_called = true;
+      } );
+      expect( first_cancelled, "the closed descriptor's rule to be cancelled when its number was reused" );
+
+      UDPSocket sender;
+      sender.sendto( second.local_address(), "x" );
+      expect( loop.wait_next_event( 1000 ) == EventLoop::Result::Success, "an event on the new descriptor" );
+      expect( second_called, "the new descriptor's rule to run" );
+    }
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
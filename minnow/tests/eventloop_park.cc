@@ -0,0 +1,94 @@
+#include "eventloop.hh"
+#include "socket.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+
+void expect( bool condition, const string& what )
+{
+  if ( not condition ) {
+    throw runtime_error( "EventLoop: expected " + what );
+  }
+}
+
+void wait( EventLoop& loop, size_t n_waits )
+{
+  for ( size_t i = 0; i < n_waits; i++ ) {
+    loop.wait_next_event( 10 );
+  }
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    // A socket that is always writable, with a rule that is interested only when `want` is set
+    EventLoop loop;
+    UDPSocket socket;
+    bool want = false;
+    size_t n_asked = 0;
+    size_t n_called = 0;
+    EventLoop::RuleHandle rule = loop.add_rule(
+      socket,
+      EventLoop::Direction::Out,
+      [&] {
+        n_called++;
+        want = false;
+      },
+      [&] {
+        n_asked++;
+        return want;
+      } );
+    loop.add_timer( milliseconds { 1 }, [] {}, true ); // keeps the loop waiting
+
+    // A parked rule's interest is not asked on every wait
+    wait( loop, 5 );
+    expect( n_asked == 1 and n_called == 0, "the rule to be asked once, when it was added, and parked" );
+    want = true;
+    wait( loop, 5 );
+    expect( n_asked == 1 and n_called == 0, "a parked rule to stay parked until woken" );
+
+    // Woken while interested, it waits for events again; its callback loses interest, so the next event
+    // parks it
+    rule.wake();
+    expect( n_asked == 2, "wake() to ask the rule's interest" );
+    wait( loop, 1 );
+    expect( n_called == 1, "the woken rule to run" );
+    wait( loop, 5 );
+    expect( n_called == 1 and n_asked == 4, "the rule to be parked by the first event after its callback" );
+
+    // Woken while not interested, it stays parked; and it can be woken from a callback
+    rule.wake();
+    wait( loop, 5 );
+    expect( n_called == 1 and n_asked == 5, "a rule woken without interest to stay parked" );
+    loop.add_timer( milliseconds { 1 }, [&] {
+      want = true;
+      rule.wake();
+    } );
+    wait( loop, 5 );
+    expect( n_called == 2, "a rule woken from a timer to run" );
+
+    // Waking an unparked or cancelled rule does nothing
+    want = true;
+    rule.wake();
+    rule.wake();
+    rule.cancel();
+    rule.wake();
+    wait( loop, 5 );
+    expect( n_called == 2, "nothing after the rule was cancelled" );
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
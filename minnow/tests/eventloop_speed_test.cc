@@ -0,0 +1,161 @@
+#include "eventloop.hh"
+#include "socket.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+
+const string request( 64, 'x' );
+
+// Echoes back whatever its clients send, from rules on `loop`
+class EchoServer
+{
+  EventLoop& loop_;
+  TCPSocket listener_ {};
+  unordered_map<int, TCPSocket> connections_ {};
+  string buffer_ {};
+
+  void accept()
+  {
+    TCPSocket connection = listener_.accept();
+    connection.set_blocking( false );
+    const int fd = connection.fd_num();
+    loop_.add_rule(
+      connection,
+      EventLoop::Direction::In,
+      [this, fd] {
+        TCPSocket& socket = connections_.at( fd );
+        socket.read( buffer_ );
+        if ( not buffer_.empty() ) {
+          socket.write( buffer_ );
+        }
+      },
+      {},
+      [this, fd] { connections_.erase( fd ); } );
+    connections_.emplace( fd, std::move( connection ) );
+  }
+
+public:
+  explicit EchoServer( EventLoop& loop ) : loop_( loop )
+  {
+    listener_.set_reuseaddr();
+    listener_.bind( Address { "127.0.0.1" } );
+    listener_.listen( 4096 );
+    loop_.add_rule( listener_, EventLoop::Direction::In, [this] { accept(); } );
+  }
+
+  Address address() const { return listener_.local_address(); }
+};
+
+// A client that sends `n_requests` requests, one at a time, each after the echo of the one before
+void start_client( EventLoop& loop, const Address& server, size_t n_requests, size_t& n_completed )
+{
+  auto socket = make_shared<TCPSocket>();
+  socket->connect( server );
+  socket->set_blocking( false );
+  socket->write( request );
+
+  auto outstanding = make_shared<size_t>( request.size() );
+  auto buffer = make_shared<string>();
+  loop.add_rule( *socket, EventLoop::Direction::In, [=, &n_completed]() mutable {
+    socket->read( *buffer );
+    *outstanding -= buffer->size();
+    if ( *outstanding > 0 ) {
+      return;
+    }
+    n_completed++;
+    if ( --n_requests == 0 ) {
+      socket->close();
+      return;
+    }
+    socket->write( request );
+    *outstanding = request.size();
+  } );
+}
+
+void run_until( EventLoop& loop, const size_t& n_completed, size_t target )
+{
+  while ( n_completed < target ) {
+    if ( loop.wait_next_event( 1000 ) != EventLoop::Result::Success ) {
+      throw runtime_error( "echo benchmark stalled" );
+    }
+  }
+}
+
+// Requests per second over `n_connections` connections, each making `n_requests` round trips
+double request_rate( size_t n_connections, size_t n_requests )
+{
+  EventLoop loop;
+  const EchoServer server { loop };
+  size_t n_completed = 0;
+
+  for ( size_t i = 0; i < n_connections; i++ ) {
+    start_client( loop, server.address(), n_requests, n_completed );
+  }
+
+  const auto start_time = steady_clock::now();
+  run_until( loop, n_completed, n_connections * n_requests );
+  const auto stop_time = steady_clock::now();
+
+  return static_cast<double>( n_completed ) / duration_cast<duration<double>>( stop_time - start_time ).count();
+}
+
+// Connections per second, each making a single round trip, with up to `concurrency` open at once
+double connection_rate( size_t n_connections, size_t concurrency )
+{
+  EventLoop loop;
+  const EchoServer server { loop };
+  size_t n_completed = 0;
+  size_t n_started = 0;
+
+  const auto start_time = steady_clock::now();
+  while ( n_completed < n_connections ) {
+    while ( n_started < n_connections and n_started - n_completed < concurrency ) {
+      start_client( loop, server.address(), 1, n_completed );
+      n_started++;
+    }
+    run_until( loop, n_completed, n_completed + 1 );
+  }
+  const auto stop_time = steady_clock::now();
+
+  return static_cast<double>( n_completed ) / duration_cast<duration<double>>( stop_time - start_time ).count();
+}
+
+} // namespace
+
+void program_body()
+{
+  const double requests_per_second = request_rate( 1000, 100 );
+  const double connections_per_second = connection_rate( 10000, 100 );
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "Loopback echo through one EventLoop: " << fixed << setprecision( 0 ) << requests_per_second
+       << " requests/s over 1000 connections, " << connections_per_second << " connections/s.\n";
+
+  debug_output << "      EventLoop echo: " << fixed << setprecision( 0 ) << requests_per_second << " requests/s, "
+               << connections_per_second << " connections/s\n";
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
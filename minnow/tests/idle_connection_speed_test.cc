@@ -0,0 +1,168 @@
+#include "byte_stream.hh"
+#include "connection_table.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <malloc.h>
+#include <new>
+#include <string>
+
+using namespace std;
+using namespace std::chrono;
+
+// Track the bytes the program has live on the heap
+namespace {
+size_t live_bytes = 0;
+
+// Kept out of line, so the compiler does not pair each inlined free() with the operator new it came from
+[[gnu::noinline]] void release( void* p )
+{
+  live_bytes -= malloc_usable_size( p );
+  free( p ); // NOLINT(*-no-malloc, *-owning-memory)
+}
+} // namespace
+
+void* operator new( size_t size )
+{
+  if ( void* p = malloc( size ) ) { // NOLINT(*-no-malloc, *-owning-memory)
+    live_bytes += malloc_usable_size( p );
+    return p;
+  }
+  throw bad_alloc();
+}
+
+void operator delete( void* p ) noexcept
+{
+  release( p );
+}
+
+void operator delete( void* p, size_t /* size */ ) noexcept
+{
+  release( p );
+}
+
+namespace {
+
+constexpr size_t n_connections = 1'000'000;
+constexpr size_t batch = 10'000; // connections opened (and measured) at a time
+constexpr uint32_t server_ip = 0x0a000001;
+constexpr uint16_t server_port = 80;
+
+FourTuple client( size_t i )
+{
+  return { server_ip,
+           static_cast<uint32_t>( 0x0a010000 + i / 50'000 ),
+           server_port,
+           static_cast<uint16_t>( 10'000 + i % 50'000 ) };
+}
+
+// A segment from the client. Both sides use an ISN of 0.
+TCPSegment from_client( const FourTuple& tuple, uint32_t seqno, bool SYN, const string& payload = {} )
+{
+  TCPSegment segment;
+  segment.src_port = tuple.remote_port;
+  segment.dst_port = tuple.local_port;
+  segment.message.sender = { .seqno = Wrap32 { seqno }, .SYN = SYN, .payload = payload };
+  if ( not SYN ) {
+    segment.message.receiver = { .ackno = Wrap32 { 1 + 5 }, .window_size = 64000 };
+  }
+  return segment;
+}
+
+// The client says hello and the server answers, then the client acknowledges the answer
+void exchange( ConnectionTable& table, const FourTuple& tuple, uint32_t client_seqno, const string& greeting )
+{
+  const auto id
+    = table.receive( tuple.remote_ip, tuple.local_ip, from_client( tuple, client_seqno, false, greeting ) );
+  if ( not id ) {
+    throw runtime_error( "segment was dropped" );
+  }
+  TCPPeer& peer = table.connection( *id ).peer;
+
+  string received;
+  read( peer.inbound_reader(), greeting.size(), received );
+  if ( received != greeting ) {
+    throw runtime_error( "server received \"" + received + "\"" );
+  }
+  peer.outbound_writer().push( "world" );
+  peer.push();
+  while ( peer.maybe_send() ) {}
+
+  table.receive( tuple.remote_ip,
+                 tuple.local_ip,
+                 from_client( tuple, client_seqno + static_cast<uint32_t>( greeting.size() ), false ) );
+}
+
+void speed_test()
+{
+  TCPConfig config;
+  config.fixed_isn = Wrap32 { 0 };
+  ConnectionTable table { config };
+  table.listen( server_ip, server_port, batch );
+
+  const size_t bytes_at_start = live_bytes;
+  size_t bytes_before_compaction = 0;
+  steady_clock::duration compacting {};
+
+  for ( size_t first = 0; first < n_connections; first += batch ) {
+    // Open a batch of connections, each of which exchanges a few bytes each way and then goes idle
+    const size_t bytes_before_batch = live_bytes;
+    for ( size_t i = first; i < first + batch; i++ ) {
+      const FourTuple tuple = client( i );
+      const auto id = table.receive( tuple.remote_ip, tuple.local_ip, from_client( tuple, 0, true ) );
+      if ( not id or not table.accept( server_ip, server_port ) ) {
+        throw runtime_error( "connection was not accepted" );
+      }
+      while ( table.connection( *id ).peer.maybe_send() ) {}
+      exchange( table, tuple, 1, "hello" );
+    }
+    bytes_before_compaction += live_bytes - bytes_before_batch;
+
+    // Time passes with nothing to do, and the idle connections compact themselves
+    const auto start_time = steady_clock::now();
+    for ( size_t i = first; i < first + batch; i++ ) {
+      table.connection( *table.find( client( i ) ) ).peer.tick( config.idle_compact_ms );
+    }
+    compacting += steady_clock::now() - start_time;
+  }
+
+  const double before = static_cast<double>( bytes_before_compaction ) / n_connections;
+  const double after = static_cast<double>( live_bytes - bytes_at_start ) / n_connections;
+  const double compact_ns = duration_cast<duration<double, nano>>( compacting ).count() / n_connections;
+
+  // A compacted connection picks up where it left off
+  exchange( table, client( 0 ), 6, "again" );
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << n_connections << " idle connections: " << fixed << setprecision( 0 ) << before
+       << " bytes of heap each before compaction, " << after << " after (" << compact_ns
+       << " ns to compact each).\n";
+
+  debug_output << "      idle connections (" << n_connections << "): " << fixed << setprecision( 0 ) << after
+               << " B/connection compacted (before: " << before << " B), " << compact_ns << " ns/compaction\n";
+}
+
+} // namespace
+
+void program_body()
+{
+  speed_test();
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
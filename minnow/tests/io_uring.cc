@@ -0,0 +1,94 @@
+#include "io_uring.hh"
+
+#include "exception.hh"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+void expect( bool condition, const string& what )
+{
+  if ( not condition ) {
+    throw runtime_error( "IOUring: expected " + what );
+  }
+}
+
+// Submit what is queued, and wait for its one completion
+int32_t complete_one( IOUring& ring )
+{
+  ring.submit( 1 );
+  vector<IOUring::Completion> completions;
+  while ( ring.reap( completions ) == 0 ) {
+    ring.submit( 1 );
+  }
+  expect( completions.size() == 1, "one completion" );
+  return completions.front().result;
+}
+
+off_t position( const FileDescriptor& fd )
+{
+  return CheckSystemCall( "lseek", ::lseek( fd.fd_num(), 0, SEEK_CUR ) );
+}
+
+// On a seekable file, each read and write is at the current position and moves it on, as with FileDescriptor
+void current_position()
+{
+  FileDescriptor file { CheckSystemCall( "memfd_create", ::memfd_create( "io_uring_test", 0 ) ) };
+  IOUring ring { 4 };
+  ring.register_buffers( 3, 64 );
+  ring.acquire_buffer();
+  const auto to_send = static_cast<uint16_t>( ring.acquire_buffer() );
+  const auto to_receive = static_cast<uint16_t>( ring.acquire_buffer() );
+  expect( to_send != 0 and to_receive != 0, "buffers other than the first" );
+
+  const string hello = "hello";
+  ring.write( file, hello, 0 );
+  expect( complete_one( ring ) == 5, "the first write to complete" );
+  memcpy( ring.buffer( to_send ).data(), ", world", 7 );
+  ring.write_fixed( file, to_send, 7, 0 );
+  expect( complete_one( ring ) == 7, "the fixed write to complete" );
+  expect( position( file ) == 12, "the second write to follow the first" );
+
+  CheckSystemCall( "lseek", ::lseek( file.fd_num(), 0, SEEK_SET ) );
+  string first( 5, 0 );
+  ring.read( file, first, 0 );
+  expect( complete_one( ring ) == 5 and first == "hello", "a read from the start" );
+  ring.read_fixed( file, to_receive, 64, 0 );
+  expect( complete_one( ring ) == 7, "the fixed read to go on from the first" );
+  expect( string_view { ring.buffer( to_receive ).data(), 7 } == ", world",
+          "the fixed read to land in its own buffer" );
+  expect( position( file ) == 12, "the reads to move the position to the end" );
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    optional<IOUring> probe;
+    try {
+      probe.emplace( 1 );
+    } catch ( const unix_error& e ) {
+      cout << "io_uring is not available here (" << e.what() << "), skipping.\n";
+      return EXIT_SUCCESS;
+    }
+    probe.reset();
+
+    current_position();
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
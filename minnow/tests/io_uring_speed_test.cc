@@ -0,0 +1,152 @@
+#include "exception.hh"
+#include "file_descriptor.hh"
+#include "io_uring.hh"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <sys/socket.h>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+
+constexpr size_t batch = 8;          // messages in flight at once
+constexpr size_t read_size = 16384;  // as much as FileDescriptor::read asks for
+constexpr size_t n_batches = 1 << 15;
+
+array<FileDescriptor, 2> socket_pair()
+{
+  array<int, 2> fds {};
+  CheckSystemCall( "socketpair", ::socketpair( AF_UNIX, SOCK_SEQPACKET, 0, fds.data() ) );
+  return { FileDescriptor { fds[0] }, FileDescriptor { fds[1] } };
+}
+
+// Send batches of messages and read them back with FileDescriptor::write and read; returns ns per message
+double time_file_descriptor( const string& message )
+{
+  auto [tx, rx] = socket_pair();
+  string received;
+
+  const auto start_time = steady_clock::now();
+  for ( size_t i = 0; i < n_batches; i++ ) {
+    for ( size_t j = 0; j < batch; j++ ) {
+      tx.write( message );
+    }
+    for ( size_t j = 0; j < batch; j++ ) {
+      rx.read( received );
+      if ( received.size() != message.size() ) {
+        throw runtime_error( "message arrived truncated" );
+      }
+    }
+  }
+  const auto stop_time = steady_clock::now();
+
+  if ( received != message ) {
+    throw runtime_error( "message arrived garbled" );
+  }
+  return duration_cast<duration<double, nano>>( stop_time - start_time ).count() / ( n_batches * batch );
+}
+
+// The same through an IOUring: each batch of writes and reads goes to the kernel in one system call, from
+// and into registered buffers; returns ns per message
+double time_io_uring( const string& message )
+{
+  auto [tx, rx] = socket_pair();
+  IOUring ring { 2 * batch };
+  ring.register_buffers( batch + 1, read_size );
+
+  const auto to_send = static_cast<uint16_t>( ring.acquire_buffer() );
+  memcpy( ring.buffer( to_send ).data(), message.data(), message.size() );
+  array<uint16_t, batch> to_receive {};
+  for ( auto& index : to_receive ) {
+    index = static_cast<uint16_t>( ring.acquire_buffer() );
+  }
+
+  vector<IOUring::Completion> completions;
+  completions.reserve( 2 * batch );
+
+  const auto start_time = steady_clock::now();
+  for ( size_t i = 0; i < n_batches; i++ ) {
+    for ( size_t j = 0; j < batch; j++ ) {
+      ring.write_fixed( tx, to_send, message.size(), batch + j );
+    }
+    for ( size_t j = 0; j < batch; j++ ) {
+      ring.read_fixed( rx, to_receive[j], read_size, j );
+    }
+    ring.submit( 2 * batch );
+
+    completions.clear();
+    while ( completions.size() < 2 * batch ) {
+      if ( ring.reap( completions ) == 0 ) {
+        ring.submit( 2 * batch - completions.size() );
+      }
+    }
+    for ( const auto& completion : completions ) {
+      if ( completion.result != static_cast<int32_t>( message.size() ) ) {
+        throw runtime_error( "io_uring operation returned " + to_string( completion.result ) );
+      }
+    }
+  }
+  const auto stop_time = steady_clock::now();
+
+  if ( string_view { ring.buffer( to_receive.back() ).data(), message.size() } != message ) {
+    throw runtime_error( "message arrived garbled" );
+  }
+  return duration_cast<duration<double, nano>>( stop_time - start_time ).count() / ( n_batches * batch );
+}
+
+void speed_test( size_t message_size )
+{
+  string message( message_size, 0 );
+  for ( size_t i = 0; i < message_size; i++ ) {
+    message[i] = static_cast<char>( i * 7 );
+  }
+
+  const double fd_ns = time_file_descriptor( message );
+  const double uring_ns = time_io_uring( message );
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << message_size << "-byte messages through a socketpair: " << fixed << setprecision( 0 ) << uring_ns
+       << " ns each with io_uring (batches of " << batch << "), " << fd_ns << " ns with FileDescriptor.\n";
+
+  debug_output << "      io_uring write+read (" << message_size << " B): " << fixed << setprecision( 0 )
+               << uring_ns << " ns/message (FileDescriptor: " << fd_ns << " ns)\n";
+}
+
+} // namespace
+
+void program_body()
+{
+  try {
+    const IOUring probe { 1 };
+  } catch ( const unix_error& e ) {
+    cout << "io_uring is not available here (" << e.what() << "), skipping.\n";
+    return;
+  }
+
+  speed_test( 64 );
+  speed_test( 1500 );
+  speed_test( 16384 );
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
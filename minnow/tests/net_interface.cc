@@ -50,7 +50,7 @@ ARPMessage make_arp( const uint16_t opcode,
 EthernetFrame make_frame( const EthernetAddress& src,
                           const EthernetAddress& dst,
                           const uint16_t type,
-                          vector<Buffer> payload )
+                          BufferChain payload )
 {
   EthernetFrame frame;
   frame.header.src = src;
@@ -320,6 +320,314 @@ int main()
         serialize( make_arp( ARPMessage::OPCODE_REQUEST, local_eth, "10.0.0.1", {}, "10.0.0.5" ) ) ) } );
       test.execute( ExpectNoFrame {} );
     }
+
+    {
+      const EthernetAddress local_eth = random_private_ethernet_address();
+      const EthernetAddress remote_eth = random_private_ethernet_address();
+      NetworkInterfaceTestHarness test {
+        "unresolved next hop does not block resolved ones", local_eth, Address( "10.0.0.1", 0 ) };
+
+      // learn 10.0.0.5 from its ARP request
+      test.execute( ReceiveFrame {
+        make_frame( remote_eth,
+                    ETHERNET_BROADCAST,
+                    EthernetHeader::TYPE_ARP,
+                    serialize( make_arp( ARPMessage::OPCODE_REQUEST, remote_eth, "10.0.0.5", {}, "10.0.0.1" ) ) ),
+        {} } );
+      test.execute( ExpectFrame { make_frame(
+        local_eth,
+        remote_eth,
+        EthernetHeader::TYPE_ARP,
+        serialize( make_arp( ARPMessage::OPCODE_REPLY, local_eth, "10.0.0.1", remote_eth, "10.0.0.5" ) ) ) } );
+
+      // a datagram to an unknown next hop waits for ARP...
+      const auto blocked = make_datagram( "5.6.7.8", "13.12.11.10" );
+      test.execute( SendDatagram { blocked, Address( "10.0.0.9", 0 ) } );
+      test.execute( ExpectFrame { make_frame(
+        local_eth,
+        ETHERNET_BROADCAST,
+        EthernetHeader::TYPE_ARP,
+        serialize( make_arp( ARPMessage::OPCODE_REQUEST, local_eth, "10.0.0.1", {}, "10.0.0.9" ) ) ) } );
+      test.execute( ExpectPendingDatagrams { 1 } );
+
+      // ...but one sent later to the resolved neighbor goes out immediately
+      const auto resolved = make_datagram( "5.6.7.8", "4.10.4.10" );
+      test.execute( SendDatagram { resolved, Address( "10.0.0.5", 0 ) } );
+      test.execute(
+        ExpectFrame { make_frame( local_eth, remote_eth, EthernetHeader::TYPE_IPv4, serialize( resolved ) ) } );
+      test.execute( ExpectNoFrame {} );
+
+      // the reply releases everything that was waiting, in order
+      const auto blocked2 = make_datagram( "5.6.7.8", "13.12.11.11" );
+      test.execute( SendDatagram { blocked2, Address( "10.0.0.9", 0 ) } );
+      test.execute( ExpectNoFrame {} );
+      test.execute( ExpectPendingDatagrams { 2 } );
+      const EthernetAddress late_eth = random_private_ethernet_address();
+      test.execute( ReceiveFrame {
+        make_frame(
+          late_eth,
+          local_eth,
+          EthernetHeader::TYPE_ARP,
+          serialize( make_arp( ARPMessage::OPCODE_REPLY, late_eth, "10.0.0.9", local_eth, "10.0.0.1" ) ) ),
+        {} } );
+      test.execute( ExpectPendingDatagrams { 0 } );
+      test.execute(
+        ExpectFrame { make_frame( local_eth, late_eth, EthernetHeader::TYPE_IPv4, serialize( blocked ) ) } );
+      test.execute(
+        ExpectFrame { make_frame( local_eth, late_eth, EthernetHeader::TYPE_IPv4, serialize( blocked2 ) ) } );
+      test.execute( ExpectNoFrame {} );
+    }
+
+    {
+      const EthernetAddress local_eth = random_private_ethernet_address();
+      NetworkInterfaceTestHarness test {
+        "pending queue per next hop is bounded", local_eth, Address( "1.2.3.4", 0 ) };
+
+      const auto datagram = make_datagram( "5.6.7.8", "13.12.11.10" );
+      for ( size_t i = 0; i < NetworkInterface::MAX_PENDING_PER_HOP + 3; i++ ) {
+        test.execute( SendDatagram { datagram, Address( "10.0.0.1", 0 ) } );
+      }
+      test.execute( ExpectFrame {
+        make_frame( local_eth,
+                    ETHERNET_BROADCAST,
+                    EthernetHeader::TYPE_ARP,
+                    serialize( make_arp( ARPMessage::OPCODE_REQUEST, local_eth, "1.2.3.4", {}, "10.0.0.1" ) ) ) } );
+      test.execute( ExpectNoFrame {} );
+      test.execute( ExpectPendingDatagrams { NetworkInterface::MAX_PENDING_PER_HOP } );
+      test.execute( ExpectDroppedDatagrams { 3 } );
+
+      // another next hop has its own queue
+      test.execute( SendDatagram { datagram, Address( "10.0.0.2", 0 ) } );
+      test.execute( ExpectPendingDatagrams { NetworkInterface::MAX_PENDING_PER_HOP + 1 } );
+      test.execute( ExpectDroppedDatagrams { 3 } );
+    }
+
+    {
+      const EthernetAddress local_eth = random_private_ethernet_address();
+      const EthernetAddress remote_eth = random_private_ethernet_address();
+      NetworkInterfaceTestHarness test { "frames move in bursts", local_eth, Address( "10.0.0.1", 0 ) };
+
+      // a burst mixing an ARP request and two datagrams for us
+      const auto in1 = make_datagram( "13.12.11.10", "5.6.7.8" );
+      const auto in2 = make_datagram( "13.12.11.11", "5.6.7.8" );
+      test.execute( ReceiveFrameBurst {
+        { make_frame( remote_eth, local_eth, EthernetHeader::TYPE_IPv4, serialize( in1 ) ),
+          make_frame( remote_eth,
+                      ETHERNET_BROADCAST,
+                      EthernetHeader::TYPE_ARP,
+                      serialize( make_arp( ARPMessage::OPCODE_REQUEST, remote_eth, "10.0.0.5", {}, "10.0.0.1" ) ) ),
+          make_frame( remote_eth, local_eth, EthernetHeader::TYPE_IPv4, serialize( in2 ) ) },
+        { in1, in2 } } );
+
+      const auto out1 = make_datagram( "5.6.7.8", "13.12.11.10" );
+      const auto out2 = make_datagram( "5.6.7.8", "13.12.11.11" );
+      test.execute( SendDatagram { out1, Address( "10.0.0.5", 0 ) } );
+      test.execute( SendDatagram { out2, Address( "10.0.0.5", 0 ) } );
+
+      // the ARP reply and both datagrams come out in order, at most two per burst
+      test.execute( ExpectFrameBurst {
+        2,
+        { make_frame(
+            local_eth,
+            remote_eth,
+            EthernetHeader::TYPE_ARP,
+            serialize( make_arp( ARPMessage::OPCODE_REPLY, local_eth, "10.0.0.1", remote_eth, "10.0.0.5" ) ) ),
+          make_frame( local_eth, remote_eth, EthernetHeader::TYPE_IPv4, serialize( out1 ) ) } } );
+      test.execute( ExpectFrameBurst {
+        2, { make_frame( local_eth, remote_eth, EthernetHeader::TYPE_IPv4, serialize( out2 ) ) } } );
+      test.execute( ExpectFrameBurst { 2, {} } );
+    }
+
+    {
+      const EthernetAddress local_eth = random_private_ethernet_address();
+      const EthernetAddress gateway_eth = random_private_ethernet_address();
+      NetworkInterfaceTestHarness test {
+        "static neighbors never wait or expire", local_eth, Address( "10.0.0.1", 0 ) };
+
+      test.execute( AddStaticNeighbor { Address( "10.0.0.254", 0 ), gateway_eth } );
+      const auto datagram = make_datagram( "10.0.0.1", "13.12.11.10" );
+      test.execute( SendDatagram { datagram, Address( "10.0.0.254", 0 ) } );
+      test.execute(
+        ExpectFrame { make_frame( local_eth, gateway_eth, EthernetHeader::TYPE_IPv4, serialize( datagram ) ) } );
+      test.execute( ExpectNoFrame {} );
+
+      // ARP traffic does not override the configured mapping
+      const EthernetAddress impostor_eth = random_private_ethernet_address();
+      test.execute( ReceiveFrame {
+        make_frame(
+          impostor_eth,
+          local_eth,
+          EthernetHeader::TYPE_ARP,
+          serialize( make_arp( ARPMessage::OPCODE_REPLY, impostor_eth, "10.0.0.254", local_eth, "10.0.0.1" ) ) ),
+        {} } );
+
+      test.execute( Tick { 120000 } );
+      const auto datagram2 = make_datagram( "10.0.0.1", "13.12.11.11" );
+      test.execute( SendDatagram { datagram2, Address( "10.0.0.254", 0 ) } );
+      test.execute(
+        ExpectFrame { make_frame( local_eth, gateway_eth, EthernetHeader::TYPE_IPv4, serialize( datagram2 ) ) } );
+      test.execute( ExpectNoFrame {} );
+      test.execute( ExpectDelayedDatagrams { 0 } );
+    }
+
+    {
+      const EthernetAddress local_eth = random_private_ethernet_address();
+      const EthernetAddress remote_eth = random_private_ethernet_address();
+      NetworkInterfaceTestHarness test { "learn from gratuitous ARP", local_eth, Address( "10.0.0.1", 0 ) };
+
+      test.execute( Announce {} );
+      test.execute( ExpectFrame { make_frame(
+        local_eth,
+        ETHERNET_BROADCAST,
+        EthernetHeader::TYPE_ARP,
+        serialize( make_arp( ARPMessage::OPCODE_REQUEST, local_eth, "10.0.0.1", {}, "10.0.0.1" ) ) ) } );
+
+      // a neighbor announcing itself is learned without a reply
+      test.execute( ReceiveFrame {
+        make_frame( remote_eth,
+                    ETHERNET_BROADCAST,
+                    EthernetHeader::TYPE_ARP,
+                    serialize( make_arp( ARPMessage::OPCODE_REQUEST, remote_eth, "10.0.0.7", {}, "10.0.0.7" ) ) ),
+        {} } );
+      test.execute( ExpectNoFrame {} );
+
+      const auto datagram = make_datagram( "10.0.0.1", "13.12.11.10" );
+      test.execute( SendDatagram { datagram, Address( "10.0.0.7", 0 ) } );
+      test.execute(
+        ExpectFrame { make_frame( local_eth, remote_eth, EthernetHeader::TYPE_IPv4, serialize( datagram ) ) } );
+      test.execute( ExpectNoFrame {} );
+      test.execute( ExpectDelayedDatagrams { 0 } );
+    }
+
+    {
+      const EthernetAddress local_eth = random_private_ethernet_address();
+      const EthernetAddress remote_eth = random_private_ethernet_address();
+      NetworkInterfaceTestHarness test {
+        "IPv4 from a neighbor confirms its mapping", local_eth, Address( "10.0.0.1", 0 ) };
+
+      test.execute( ReceiveFrame {
+        make_frame( remote_eth,
+                    ETHERNET_BROADCAST,
+                    EthernetHeader::TYPE_ARP,
+                    serialize( make_arp( ARPMessage::OPCODE_REQUEST, remote_eth, "10.0.0.5", {}, "10.0.0.1" ) ) ),
+        {} } );
+      test.execute( ExpectFrame { make_frame(
+        local_eth,
+        remote_eth,
+        EthernetHeader::TYPE_ARP,
+        serialize( make_arp( ARPMessage::OPCODE_REPLY, local_eth, "10.0.0.1", remote_eth, "10.0.0.5" ) ) ) } );
+
+      test.execute( Tick { 20000 } );
+      const auto incoming = make_datagram( "10.0.0.5", "10.0.0.1" );
+      test.execute( ReceiveFrame {
+        make_frame( remote_eth, local_eth, EthernetHeader::TYPE_IPv4, serialize( incoming ) ), incoming } );
+
+      // 40 s after the ARP exchange, but only 20 s after the neighbor was last heard from
+      test.execute( Tick { 20000 } );
+      const auto datagram = make_datagram( "10.0.0.1", "10.0.0.5" );
+      test.execute( SendDatagram { datagram, Address( "10.0.0.5", 0 ) } );
+      test.execute(
+        ExpectFrame { make_frame( local_eth, remote_eth, EthernetHeader::TYPE_IPv4, serialize( datagram ) ) } );
+      test.execute( ExpectNoFrame {} );
+      test.execute( ExpectDelayedDatagrams { 0 } );
+    }
+
+    {
+      const EthernetAddress local_eth = random_private_ethernet_address();
+      const EthernetAddress remote_eth = random_private_ethernet_address();
+      NetworkInterfaceTestHarness test {
+        "mappings in use are refreshed before they expire", local_eth, Address( "10.0.0.1", 0 ) };
+
+      test.execute( SetRefreshLead { 5000 } );
+      const auto datagram = make_datagram( "10.0.0.1", "13.12.11.10" );
+      test.execute( SendDatagram { datagram, Address( "10.0.0.5", 0 ) } );
+      test.execute( ExpectFrame { make_frame(
+        local_eth,
+        ETHERNET_BROADCAST,
+        EthernetHeader::TYPE_ARP,
+        serialize( make_arp( ARPMessage::OPCODE_REQUEST, local_eth, "10.0.0.1", {}, "10.0.0.5" ) ) ) } );
+      const auto reply = make_frame(
+        remote_eth,
+        local_eth,
+        EthernetHeader::TYPE_ARP,
+        serialize( make_arp( ARPMessage::OPCODE_REPLY, remote_eth, "10.0.0.5", local_eth, "10.0.0.1" ) ) );
+      test.execute( ReceiveFrame { reply, {} } );
+      test.execute(
+        ExpectFrame { make_frame( local_eth, remote_eth, EthernetHeader::TYPE_IPv4, serialize( datagram ) ) } );
+      test.execute( ExpectDelayedDatagrams { 1 } );
+
+      // 25 s in, the mapping is in use, so it is re-requested directly from the neighbor
+      test.execute( Tick { 24990 } );
+      test.execute( ExpectNoFrame {} );
+      test.execute( Tick { 10 } );
+      test.execute( ExpectFrame { make_frame(
+        local_eth,
+        remote_eth,
+        EthernetHeader::TYPE_ARP,
+        serialize( make_arp( ARPMessage::OPCODE_REQUEST, local_eth, "10.0.0.1", {}, "10.0.0.5" ) ) ) } );
+      test.execute( ExpectNoFrame {} );
+      test.execute( ReceiveFrame { reply, {} } );
+
+      // well past the original 30 s, traffic still flows without waiting
+      test.execute( Tick { 10000 } );
+      const auto datagram2 = make_datagram( "10.0.0.1", "13.12.11.11" );
+      test.execute( SendDatagram { datagram2, Address( "10.0.0.5", 0 ) } );
+      test.execute(
+        ExpectFrame { make_frame( local_eth, remote_eth, EthernetHeader::TYPE_IPv4, serialize( datagram2 ) ) } );
+      test.execute( ExpectNoFrame {} );
+      test.execute( ExpectDelayedDatagrams { 1 } );
+
+      // an unanswered refresh lets the mapping lapse on schedule
+      test.execute( Tick { 30000 } );
+      test.execute( ExpectFrame { make_frame(
+        local_eth,
+        remote_eth,
+        EthernetHeader::TYPE_ARP,
+        serialize( make_arp( ARPMessage::OPCODE_REQUEST, local_eth, "10.0.0.1", {}, "10.0.0.5" ) ) ) } );
+      test.execute( ExpectNoFrame {} );
+      test.execute( SendDatagram { datagram2, Address( "10.0.0.5", 0 ) } );
+      test.execute( ExpectFrame { make_frame(
+        local_eth,
+        ETHERNET_BROADCAST,
+        EthernetHeader::TYPE_ARP,
+        serialize( make_arp( ARPMessage::OPCODE_REQUEST, local_eth, "10.0.0.1", {}, "10.0.0.5" ) ) ) } );
+      test.execute( ExpectDelayedDatagrams { 2 } );
+    }
+
+    {
+      const EthernetAddress local_eth = random_private_ethernet_address();
+      NetworkInterfaceTestHarness test {
+        "unanswered next hop is given up on", local_eth, Address( "10.0.0.1", 0 ) };
+
+      const auto request = make_frame(
+        local_eth,
+        ETHERNET_BROADCAST,
+        EthernetHeader::TYPE_ARP,
+        serialize( make_arp( ARPMessage::OPCODE_REQUEST, local_eth, "10.0.0.1", {}, "10.0.0.9" ) ) );
+
+      test.execute( SendDatagram { make_datagram( "5.6.7.8", "13.12.11.10" ), Address( "10.0.0.9", 0 ) } );
+      test.execute( SendDatagram { make_datagram( "5.6.7.8", "13.12.11.11" ), Address( "10.0.0.9", 0 ) } );
+      test.execute( ExpectFrame { request } );
+      test.execute( Tick { 5000 } );
+      test.execute( ExpectFrame { request } );
+      test.execute( Tick { 5000 } );
+      test.execute( ExpectFrame { request } );
+      test.execute( ExpectPendingDatagrams { 2 } );
+      test.execute( ExpectDroppedDatagrams { 0 } );
+
+      // No reply to the third request: the queued datagrams are dropped, and no more requests go out
+      test.execute( Tick { 5000 } );
+      test.execute( ExpectNoFrame {} );
+      test.execute( ExpectPendingDatagrams { 0 } );
+      test.execute( ExpectDroppedDatagrams { 2 } );
+      test.execute( Tick { 60000 } );
+      test.execute( ExpectNoFrame {} );
+
+      // Sending to it again starts over
+      test.execute( SendDatagram { make_datagram( "5.6.7.8", "13.12.11.12" ), Address( "10.0.0.9", 0 ) } );
+      test.execute( ExpectFrame { request } );
+      test.execute( ExpectPendingDatagrams { 1 } );
+    }
   } catch ( const exception& e ) {
     cerr << e.what() << endl;
     return EXIT_FAILURE;
@@ -0,0 +1,93 @@
+#include "arp_message.hh"
+#include "ethernet_header.hh"
+#include "network_interface.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+
+constexpr EthernetAddress local_eth = { 0x02, 0, 0, 0, 0, 1 };
+constexpr uint32_t local_ip = 0x0a000001; // 10.0.0.1
+
+EthernetFrame arp_request_from( uint32_t sender_ip )
+{
+  ARPMessage arp;
+  arp.opcode = ARPMessage::OPCODE_REQUEST;
+  arp.sender_ethernet_address = { 0x02, 0, static_cast<uint8_t>( sender_ip >> 24 ),
+                                  static_cast<uint8_t>( sender_ip >> 16 ), static_cast<uint8_t>( sender_ip >> 8 ),
+                                  static_cast<uint8_t>( sender_ip ) };
+  arp.sender_ip_address = sender_ip;
+  arp.target_ip_address = local_ip;
+
+  EthernetFrame frame;
+  frame.header.src = arp.sender_ethernet_address;
+  frame.header.dst = ETHERNET_BROADCAST;
+  frame.header.type = EthernetHeader::TYPE_ARP;
+  frame.payload = serialize( arp );
+  return frame;
+}
+
+} // namespace
+
+void speed_test( const size_t n_neighbors, const size_t n_ticks ) // NOLINT(bugprone-easily-swappable-parameters)
+{
+  NetworkInterface interface { local_eth, Address::from_ipv4_numeric( local_ip ) };
+
+  // Learn every neighbor from its ARP request, discarding our replies
+  for ( size_t i = 0; i < n_neighbors; i++ ) {
+    interface.recv_frame( arp_request_from( 0x0b000000 + i ) );
+    while ( interface.maybe_send().has_value() ) {}
+  }
+
+  // 1 ms ticks while every mapping is still live
+  const auto start_time = steady_clock::now();
+  for ( size_t i = 0; i < n_ticks; i++ ) {
+    interface.tick( 1 );
+  }
+  const auto live_time = steady_clock::now();
+
+  // Let every mapping expire in one go
+  interface.tick( NetworkInterface::ARP_ENTRY_TTL_MS );
+  const auto expire_time = steady_clock::now();
+
+  const double ns_per_tick = duration_cast<duration<double, nano>>( live_time - start_time ).count() / n_ticks;
+  const double ns_per_expiry
+    = duration_cast<duration<double, nano>>( expire_time - live_time ).count() / static_cast<double>( n_neighbors );
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "NetworkInterface with " << n_neighbors << " cached neighbors: " << fixed << setprecision( 1 )
+       << ns_per_tick << " ns per 1 ms tick, " << ns_per_expiry << " ns per expired entry.\n";
+
+  debug_output << "      NetworkInterface tick cost: " << fixed << setprecision( 1 ) << ns_per_tick
+               << " ns/tick with " << n_neighbors << " neighbors\n";
+
+  if ( ns_per_tick > 100000 ) {
+    throw runtime_error( "NetworkInterface::tick() took more than 100 us per tick." );
+  }
+}
+
+void program_body()
+{
+  speed_test( 100000, 20000 );
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
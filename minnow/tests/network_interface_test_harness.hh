@@ -40,8 +40,8 @@ struct SendDatagram : public Action<NetworkInterface>
 template<class T>
 bool equal( const T& t1, const T& t2 )
 {
-  const std::vector<Buffer> t1s = serialize( t1 );
-  const std::vector<Buffer> t2s = serialize( t2 );
+  const BufferChain t1s = serialize( t1 );
+  const BufferChain t2s = serialize( t2 );
 
   std::string t1concat;
   for ( const auto& x : t1s ) {
@@ -135,7 +135,128 @@ struct Tick : public Action<NetworkInterface>
   explicit Tick( const size_t ms ) : _ms( ms ) {}
 };
 
-inline std::string concat( std::vector<Buffer>& buffers )
+struct ReceiveFrameBurst : public Action<NetworkInterface>
+{
+  std::vector<EthernetFrame> frames;
+  std::vector<InternetDatagram> expected;
+
+  std::string description() const override
+  {
+    return "burst of " + std::to_string( frames.size() ) + " frames arrives, expecting "
+           + std::to_string( expected.size() ) + " datagrams";
+  }
+
+  void execute( NetworkInterface& interface ) const override
+  {
+    std::vector<InternetDatagram> result;
+    const size_t n = interface.recv_burst( frames, result );
+    if ( n != result.size() or n != expected.size() ) {
+      throw ExpectationViolation( "NetworkInterface::recv_burst() passed up " + std::to_string( n )
+                                  + " datagrams, but " + std::to_string( expected.size() )
+                                  + " were expected" );
+    }
+    for ( size_t i = 0; i < n; i++ ) {
+      if ( not equal( result[i], expected[i] ) ) {
+        throw ExpectationViolation( "NetworkInterface::recv_burst() produced a different Internet datagram than "
+                                    "was expected: actual={"
+                                    + result[i].header.to_string() + "}" );
+      }
+    }
+  }
+
+  ReceiveFrameBurst( std::vector<EthernetFrame> f, std::vector<InternetDatagram> e )
+    : frames( std::move( f ) ), expected( std::move( e ) )
+  {}
+};
+
+struct ExpectFrameBurst : public Expectation<NetworkInterface>
+{
+  size_t burst_size;
+  std::vector<EthernetFrame> expected;
+
+  std::string description() const override
+  {
+    return "burst of up to " + std::to_string( burst_size ) + " frames yields " + std::to_string( expected.size() );
+  }
+
+  void execute( NetworkInterface& interface ) const override
+  {
+    std::vector<EthernetFrame> frames( burst_size );
+    const size_t n = interface.send_burst( frames );
+    if ( n != expected.size() ) {
+      throw ExpectationViolation( "NetworkInterface::send_burst() sent " + std::to_string( n ) + " frames, but "
+                                  + std::to_string( expected.size() ) + " were expected" );
+    }
+    for ( size_t i = 0; i < n; i++ ) {
+      if ( not equal( frames[i], expected[i] ) ) {
+        throw ExpectationViolation( "NetworkInterface::send_burst() sent a different Ethernet frame than was "
+                                    "expected: actual={"
+                                    + summary( frames[i] ) + "}" );
+      }
+    }
+  }
+
+  ExpectFrameBurst( size_t b, std::vector<EthernetFrame> e ) : burst_size( b ), expected( std::move( e ) ) {}
+};
+
+struct AddStaticNeighbor : public Action<NetworkInterface>
+{
+  Address ip;
+  EthernetAddress ethernet_address;
+
+  std::string description() const override
+  {
+    return "add static neighbor " + ip.ip() + " => " + to_string( ethernet_address );
+  }
+  void execute( NetworkInterface& interface ) const override
+  {
+    interface.add_static_neighbor( ip, ethernet_address );
+  }
+
+  AddStaticNeighbor( Address i, const EthernetAddress& e ) : ip( std::move( i ) ), ethernet_address( e ) {}
+};
+
+struct Announce : public Action<NetworkInterface>
+{
+  std::string description() const override { return "announce own mapping"; }
+  void execute( NetworkInterface& interface ) const override { interface.announce(); }
+};
+
+struct SetRefreshLead : public Action<NetworkInterface>
+{
+  uint64_t lead_ms;
+
+  std::string description() const override
+  {
+    return "refresh mappings in use " + to_string( lead_ms ) + " ms early";
+  }
+  void execute( NetworkInterface& interface ) const override { interface.set_refresh_lead( lead_ms ); }
+
+  explicit SetRefreshLead( uint64_t l ) : lead_ms( l ) {}
+};
+
+struct ExpectDelayedDatagrams : public ExpectNumber<NetworkInterface, size_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "delayed_datagrams"; }
+  size_t value( NetworkInterface& interface ) const override { return interface.delayed_datagrams(); }
+};
+
+struct ExpectPendingDatagrams : public ExpectNumber<NetworkInterface, size_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "pending_datagrams"; }
+  size_t value( NetworkInterface& interface ) const override { return interface.pending_datagrams(); }
+};
+
+struct ExpectDroppedDatagrams : public ExpectNumber<NetworkInterface, size_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "dropped_datagrams"; }
+  size_t value( NetworkInterface& interface ) const override { return interface.dropped_datagrams(); }
+};
+
+inline std::string concat( const BufferChain& buffers )
 {
   return std::accumulate(
     buffers.begin(), buffers.end(), std::string {}, []( const std::string& x, const Buffer& y ) {
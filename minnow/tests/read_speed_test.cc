@@ -0,0 +1,120 @@
+#include "exception.hh"
+#include "file_descriptor.hh"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+
+constexpr size_t n_messages = 1 << 16;
+constexpr size_t batch = 16;
+constexpr size_t n_rounds = 5;
+constexpr size_t read_size = 16384;
+
+// FileDescriptor::read( std::string& ) as it used to be: the string is resized, and so zero-filled, to the
+// full read size before every read
+void read_with_zero_fill( const FileDescriptor& fd, string& buffer )
+{
+  buffer.clear();
+  buffer.resize( read_size );
+  buffer.resize( CheckSystemCall( "read", ::read( fd.fd_num(), buffer.data(), buffer.size() ) ) );
+}
+
+// Queue batches of messages on a socketpair and time reading each back with `receive`; returns ns per read
+template<typename F>
+double time_reads( const string& message, F&& receive )
+{
+  array<int, 2> fds {};
+  CheckSystemCall( "socketpair", ::socketpair( AF_UNIX, SOCK_SEQPACKET, 0, fds.data() ) );
+  FileDescriptor tx { fds[0] };
+  FileDescriptor rx { fds[1] };
+
+  steady_clock::duration reading {};
+  for ( size_t i = 0; i < n_messages / batch; i++ ) {
+    for ( size_t j = 0; j < batch; j++ ) {
+      tx.write( message );
+    }
+
+    const auto start_time = steady_clock::now();
+    for ( size_t j = 0; j < batch; j++ ) {
+      if ( receive( rx ) != message.size() ) {
+        throw runtime_error( "message arrived truncated" );
+      }
+    }
+    reading += steady_clock::now() - start_time;
+  }
+
+  return duration_cast<duration<double, nano>>( reading ).count() / n_messages;
+}
+
+void speed_test( size_t message_size )
+{
+  const string message( message_size, 'x' );
+  string buffer;
+  array<char, read_size> storage {};
+
+  // The variants take turns, and each keeps its best round, to keep noise from other work out of the comparison
+  double zero_fill_ns = numeric_limits<double>::max();
+  double string_ns = numeric_limits<double>::max();
+  double span_ns = numeric_limits<double>::max();
+  for ( size_t round = 0; round < n_rounds; round++ ) {
+    zero_fill_ns = min( zero_fill_ns, time_reads( message, [&]( FileDescriptor& fd ) {
+                          read_with_zero_fill( fd, buffer );
+                          return buffer.size();
+                        } ) );
+
+    string_ns = min( string_ns, time_reads( message, [&]( FileDescriptor& fd ) {
+                       fd.read( buffer );
+                       return buffer.size();
+                     } ) );
+    if ( buffer != message ) {
+      throw runtime_error( "message arrived garbled" );
+    }
+
+    span_ns = min( span_ns, time_reads( message, [&]( FileDescriptor& fd ) { return fd.read( storage ); } ) );
+  }
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "Reading " << message_size << "-byte messages: " << fixed << setprecision( 0 ) << string_ns
+       << " ns into a string, " << span_ns << " ns into a span, " << zero_fill_ns
+       << " ns into a string zero-filled first.\n";
+
+  debug_output << "      read (" << message_size << " B): " << fixed << setprecision( 0 ) << string_ns
+               << " ns into a string, " << span_ns << " ns into a span (zero-filled string: " << zero_fill_ns
+               << " ns)\n";
+}
+
+} // namespace
+
+void program_body()
+{
+  speed_test( 64 );
+  speed_test( 512 );
+  speed_test( 1500 );
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,119 @@
+#include "byte_stream.hh"
+#include "retransmission_timers.hh"
+#include "tcp_sender.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+
+constexpr size_t n_senders = 100'000;
+constexpr size_t active_every = 100; // one sender in this many has a segment outstanding
+constexpr uint64_t rto_ms = 100;
+constexpr uint64_t duration_ms = 400;
+
+struct Connection
+{
+  ByteStream stream { 1000 };
+  TCPSender sender { rto_ms, Wrap32 { 0 } };
+};
+
+// Open every connection by sending a SYN; most have theirs acknowledged at once, and go idle
+vector<Connection> open_connections( RetransmissionTimers* timers )
+{
+  vector<Connection> connections( n_senders );
+  for ( size_t i = 0; i < n_senders; i++ ) {
+    TCPSender& sender = connections[i].sender;
+    if ( timers ) {
+      sender.use_timers( *timers );
+    }
+    sender.push( connections[i].stream.reader() );
+    if ( not sender.maybe_send() ) {
+      throw runtime_error( "no SYN was sent" );
+    }
+    if ( i % active_every != 0 ) {
+      sender.receive( { Wrap32 { 1 }, 1000 } );
+    }
+  }
+  return connections;
+}
+
+// Send what each sender has to send; returns how many segments there were
+size_t send_all( TCPSender& sender )
+{
+  size_t sent = 0;
+  while ( sender.maybe_send() ) {
+    sent++;
+  }
+  return sent;
+}
+
+void speed_test()
+{
+  // Every millisecond, tick every sender and see whether it has a retransmission to send
+  vector<Connection> ticked = open_connections( nullptr );
+  size_t ticked_retransmissions = 0;
+  const auto tick_start = steady_clock::now();
+  for ( uint64_t ms = 0; ms < duration_ms; ms++ ) {
+    for ( auto& connection : ticked ) {
+      connection.sender.tick( 1 );
+      ticked_retransmissions += send_all( connection.sender );
+    }
+  }
+  const auto tick_stop = steady_clock::now();
+
+  // Every millisecond, advance the shared timer wheel, which only visits the senders whose timers expire
+  RetransmissionTimers timers;
+  vector<Connection> wheeled = open_connections( &timers );
+  size_t wheel_retransmissions = 0;
+  const auto wheel_start = steady_clock::now();
+  for ( uint64_t ms = 0; ms < duration_ms; ms++ ) {
+    timers.advance( 1, [&]( TCPSender& sender ) { wheel_retransmissions += send_all( sender ); } );
+  }
+  const auto wheel_stop = steady_clock::now();
+
+  if ( ticked_retransmissions != wheel_retransmissions or ticked_retransmissions == 0 ) {
+    throw runtime_error( "the timer wheel retransmitted " + to_string( wheel_retransmissions ) + " times, not "
+                         + to_string( ticked_retransmissions ) );
+  }
+
+  const double tick_ns = duration_cast<duration<double, nano>>( tick_stop - tick_start ).count() / duration_ms;
+  const double wheel_ns = duration_cast<duration<double, nano>>( wheel_stop - wheel_start ).count() / duration_ms;
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << n_senders << " senders (" << n_senders / active_every << " with a segment outstanding), "
+       << wheel_retransmissions << " retransmissions in " << duration_ms << " ms: " << fixed
+       << setprecision( 0 ) << wheel_ns << " ns per millisecond with a shared timer wheel, " << tick_ns
+       << " ns ticking every sender.\n";
+
+  debug_output << "      retransmission timers (" << n_senders << " senders): " << fixed << setprecision( 0 )
+               << wheel_ns << " ns/ms with a timer wheel (ticking each: " << tick_ns << " ns/ms)\n";
+}
+
+} // namespace
+
+void program_body()
+{
+  speed_test();
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,271 @@
+#include "random.hh"
+#include "retransmission_timers.hh"
+#include "sender_test_harness.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+struct ExpectConsecutiveRetransmissions : public ExpectNumber<StreamAndSender, uint64_t>
+{
+  using ExpectNumber::ExpectNumber;
+  std::string name() const override { return "consecutive_retransmissions"; }
+  uint64_t value( StreamAndSender& ss ) const override { return ss.sender.consecutive_retransmissions(); }
+};
+
+void expect( bool condition, const string& what )
+{
+  if ( not condition ) {
+    throw runtime_error( "RetransmissionTimers: expected " + what );
+  }
+}
+
+// The scenarios of send_retx, each run with the sender ticked and with it in RetransmissionTimers
+void scenarios( default_random_engine& rd )
+{
+  for ( const bool use_timers : { false, true } ) {
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      const uint16_t retx_timeout = uniform_int_distribution<uint16_t> { 10, 10000 }( rd );
+      cfg.fixed_isn = isn;
+      cfg.rt_timeout = retx_timeout;
+
+      TCPSenderTestHarness test { "Retx SYN twice at the right times, moving the sender", cfg, use_timers };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( MoveSender {} );
+      test.execute( Tick { retx_timeout - 1U } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( MoveSender {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( Tick { 2 * retx_timeout - 1U } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( MoveSender {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( AckReceived { Wrap32 { isn + 1 } } );
+      test.execute( ExpectSeqnosInFlight { 0 } );
+      test.execute( ExpectConsecutiveRetransmissions { 0 } );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      const uint16_t retx_timeout = uniform_int_distribution<uint16_t> { 10, 10000 }( rd );
+      cfg.fixed_isn = isn;
+      cfg.rt_timeout = retx_timeout;
+
+      TCPSenderTestHarness test { "Retx SYN until too many retransmissions", cfg, use_timers };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      for ( size_t attempt_no = 0; attempt_no < TCPConfig::MAX_RETX_ATTEMPTS; attempt_no++ ) {
+        test.execute( Tick { ( retx_timeout << attempt_no ) - 1U }.with_max_retx_exceeded( false ) );
+        test.execute( ExpectNoSegment {} );
+        test.execute( Tick { 1 }.with_max_retx_exceeded( false ) );
+        test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      }
+      test.execute(
+        Tick { ( retx_timeout << TCPConfig::MAX_RETX_ATTEMPTS ) - 1U }.with_max_retx_exceeded( false ) );
+      test.execute( Tick { 1 }.with_max_retx_exceeded( true ) );
+    }
+
+    {
+      TCPConfig cfg;
+      const Wrap32 isn( rd() );
+      const uint16_t retx_timeout = uniform_int_distribution<uint16_t> { 10, 10000 }( rd );
+      cfg.fixed_isn = isn;
+      cfg.rt_timeout = retx_timeout;
+
+      // The ack resets the RTO below the time the (backed-off) timer had already run; a stopped timer
+      // must not expire all the same
+      TCPSenderTestHarness test { "A stopped timer does not expire", cfg, use_timers };
+      test.execute( Push {} );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( Tick { retx_timeout } );
+      test.execute( ExpectMessage {}.with_no_flags().with_syn( true ).with_payload_size( 0 ).with_seqno( isn ) );
+      test.execute( Tick { retx_timeout + retx_timeout / 2U } );
+      test.execute( AckReceived { Wrap32 { isn + 1 } } );
+      test.execute( ExpectConsecutiveRetransmissions { 0 } );
+      test.execute( Tick { 8U * retx_timeout } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( ExpectConsecutiveRetransmissions { 0 } );
+
+      // And a timer started afresh runs for the initial RTO
+      test.execute( Push { "abc" } );
+      test.execute( ExpectMessage {}.with_data( "abc" ).with_seqno( isn + 1 ) );
+      test.execute( Tick { retx_timeout - 1U } );
+      test.execute( ExpectNoSegment {} );
+      test.execute( Tick { 1 } );
+      test.execute( ExpectMessage {}.with_data( "abc" ).with_seqno( isn + 1 ) );
+      test.execute( ExpectConsecutiveRetransmissions { 1 } );
+    }
+  }
+}
+
+// One sender ticked every millisecond and one in RetransmissionTimers, given the same random pushes, acks
+// and windows, must send the same segments at the same times
+void lockstep( default_random_engine& rd )
+{
+  const Wrap32 isn( rd() );
+  const uint64_t rto = uniform_int_distribution<uint64_t> { 5, 50 }( rd );
+
+  RetransmissionTimers timers;
+  ByteStream ticked_stream { 4096 };
+  ByteStream wheel_stream { 4096 };
+  TCPSender ticked { rto, isn };
+  TCPSender wheel { rto, isn };
+  wheel.use_timers( timers );
+
+  uint64_t next_seqno = 0; // one past the highest sequence number sent
+  uint64_t acked = 0;
+
+  for ( size_t step = 0; step < 20000; step++ ) {
+    const auto choice = rd() % 8;
+    if ( choice == 0 and not ticked_stream.writer().is_closed() ) {
+      const string data( rd() % 20, 'x' );
+      ticked_stream.writer().push( data );
+      wheel_stream.writer().push( data );
+      if ( rd() % 50 == 0 ) {
+        ticked_stream.writer().close();
+        wheel_stream.writer().close();
+      }
+      ticked.push( ticked_stream.reader() );
+      wheel.push( wheel_stream.reader() );
+    } else if ( choice == 1 ) {
+      acked = uniform_int_distribution<uint64_t> { acked, next_seqno }( rd );
+      const TCPReceiverMessage ack { Wrap32::wrap( acked, isn ), static_cast<uint16_t>( rd() % 100 ) };
+      ticked.receive( ack );
+      wheel.receive( ack );
+      ticked.push( ticked_stream.reader() );
+      wheel.push( wheel_stream.reader() );
+    } else {
+      ticked.tick( 1 );
+      timers.advance( 1 );
+    }
+
+    while ( true ) {
+      const optional<TCPSenderMessage> a = ticked.maybe_send();
+      const optional<TCPSenderMessage> b = wheel.maybe_send();
+      expect( a.has_value() == b.has_value(), "both senders to send at step " + to_string( step ) );
+      if ( not a.has_value() ) {
+        break;
+      }
+      expect( a->seqno == b->seqno and a->SYN == b->SYN and a->FIN == b->FIN
+                and string_view { a->payload } == string_view { b->payload },
+              "the same segment from both senders at step " + to_string( step ) );
+      next_seqno = max( next_seqno, a->seqno.unwrap( isn, next_seqno ) + a->sequence_length() );
+    }
+    expect( ticked.sequence_numbers_in_flight() == wheel.sequence_numbers_in_flight()
+              and ticked.consecutive_retransmissions() == wheel.consecutive_retransmissions(),
+            "the same state in both senders at step " + to_string( step ) );
+  }
+}
+
+// A sender that has sent its SYN, with its timer in `timers`
+void start( TCPSender& sender, RetransmissionTimers& timers )
+{
+  ByteStream stream { 64 };
+  sender.use_timers( timers );
+  sender.push( stream.reader() );
+  expect( sender.maybe_send().has_value(), "a SYN" );
+}
+
+// Senders kept in a vector are moved, with their timers armed, whenever it grows
+void move_while_armed()
+{
+  RetransmissionTimers timers;
+  vector<TCPSender> senders;
+  for ( uint32_t i = 0; i < 10; i++ ) {
+    senders.emplace_back( 100, Wrap32 { i } );
+    start( senders.back(), timers );
+  }
+  expect( timers.running() == 10, "every sender's timer to be running" );
+
+  size_t n_expired = 0;
+  timers.advance( 100, [&]( TCPSender& sender ) {
+    expect( &sender >= senders.data() and &sender < senders.data() + senders.size(),
+            "the sender where it lives now" );
+    expect( sender.maybe_send().has_value(), "a retransmission" );
+    n_expired++;
+  } );
+  expect( n_expired == 10, "every moved sender's timer to expire" );
+
+  // Moving onto a sender gives up its own timer, and takes over the other's
+  senders[0] = std::move( senders[1] );
+  expect( timers.running() == 9, "the overwritten sender's timer to be gone" );
+  n_expired = 0;
+  timers.advance( 200, [&]( TCPSender& sender ) {
+    expect( &sender != &senders[1], "nothing from the moved-from sender" );
+    n_expired++;
+  } );
+  expect( n_expired == 9, "the moved timer to expire in its new sender" );
+}
+
+// A callback may destroy the expiring sender, and others (expiring at the same time or not)
+void destroy_in_on_expire()
+{
+  RetransmissionTimers timers;
+  vector<unique_ptr<TCPSender>> senders;
+  for ( uint32_t i = 0; i < 4; i++ ) {
+    senders.push_back( make_unique<TCPSender>( 100, Wrap32 { i } ) );
+    start( *senders.back(), timers );
+  }
+
+  vector<bool> expired( senders.size() );
+  size_t n_expired = 0;
+  timers.advance( 100, [&]( TCPSender& sender ) {
+    const auto self = static_cast<size_t>(
+      find_if( senders.begin(), senders.end(), [&]( const auto& s ) { return s.get() == &sender; } )
+      - senders.begin() );
+    expect( self < senders.size(), "only live senders to expire" );
+    expired[self] = true;
+    if ( n_expired++ == 0 ) {
+      senders[self].reset();
+      for ( size_t i = 0; i < senders.size(); i++ ) {
+        if ( not expired[i] ) {
+          senders[i].reset(); // due in this same millisecond, but now gone
+          break;
+        }
+      }
+    }
+  } );
+  expect( n_expired == 3, "the destroyed sender not to expire" );
+  expect( timers.running() == 2, "the destroyed senders' timers to be gone" );
+
+  n_expired = 0;
+  timers.advance( 200, [&]( TCPSender& /* sender */ ) { n_expired++; } );
+  expect( n_expired == 2, "the remaining senders to keep expiring" );
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    auto rd = get_random_engine();
+    scenarios( rd );
+    for ( size_t i = 0; i < 10; i++ ) {
+      lockstep( rd );
+    }
+    move_while_armed();
+    destroy_in_on_expire();
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -1,18 +1,27 @@
 #pragma once
 
 #include "common.hh"
+#include "retransmission_timers.hh"
 #include "tcp_config.hh"
 #include "tcp_receiver_message.hh"
 #include "tcp_sender.hh"
 #include "wrapping_integers.hh"
 
+#include <memory>
 #include <optional>
 #include <sstream>
 #include <utility>
 
 const unsigned int DEFAULT_TEST_WINDOW = 137;
 
-using StreamAndSender = std::pair<ByteStream, TCPSender>;
+// The stream and the sender under test. If `timers` is set, the sender's retransmission timer runs there, and
+// Tick advances it instead of calling the sender's tick().
+struct StreamAndSender
+{
+  std::unique_ptr<RetransmissionTimers> timers; // declared first, so that it outlives the sender
+  ByteStream stream;
+  TCPSender sender;
+};
 
 static std::string to_string( const TCPSenderMessage& msg )
 {
@@ -39,7 +48,7 @@ struct ExpectSeqno : public ExpectNumber<StreamAndSender, Wrap32>
 
   Wrap32 value( StreamAndSender& ss ) const override
   {
-    auto seg = ss.second.send_empty_message();
+    auto seg = ss.sender.send_empty_message();
     if ( seg.sequence_length() ) {
       throw ExpectationViolation( "TCPSender::send_empty_message() returned non-empty message" );
     }
@@ -51,7 +60,7 @@ struct ExpectSeqnosInFlight : public ExpectNumber<StreamAndSender, uint64_t>
 {
   using ExpectNumber::ExpectNumber;
   std::string name() const override { return "sequence_numbers_in_flight"; }
-  uint64_t value( StreamAndSender& ss ) const override { return ss.second.sequence_numbers_in_flight(); }
+  uint64_t value( StreamAndSender& ss ) const override { return ss.sender.sequence_numbers_in_flight(); }
 };
 
 struct ExpectNoSegment : public Expectation<StreamAndSender>
@@ -59,7 +68,7 @@ struct ExpectNoSegment : public Expectation<StreamAndSender>
   std::string description() const override { return "nothing to send"; }
   void execute( StreamAndSender& ss ) const override
   {
-    const auto msg = ss.second.maybe_send();
+    const auto msg = ss.sender.maybe_send();
     if ( msg.has_value() ) {
       throw ExpectationViolation { "TCPSender sent an unexpected segment: " + to_string( msg.value() ) };
     }
@@ -88,12 +97,12 @@ struct Push : public Action<StreamAndSender>
   void execute( StreamAndSender& ss ) const override
   {
     if ( not data_.empty() ) {
-      ss.first.writer().push( data_ );
+      ss.stream.writer().push( data_ );
     }
     if ( close_ ) {
-      ss.first.writer().close();
+      ss.stream.writer().close();
     }
-    ss.second.push( ss.first.reader() );
+    ss.sender.push( ss.stream.reader() );
   }
 
   Push& with_close()
@@ -128,12 +137,16 @@ struct Tick : public Action<StreamAndSender>
 
   void execute( StreamAndSender& ss ) const override
   {
-    ss.second.tick( ms_ );
+    if ( ss.timers ) {
+      ss.timers->advance( ms_ );
+    } else {
+      ss.sender.tick( ms_ );
+    }
     if ( max_retx_exceeded_.has_value()
-         and max_retx_exceeded_ != ( ss.second.consecutive_retransmissions() > TCPConfig::MAX_RETX_ATTEMPTS ) ) {
+         and max_retx_exceeded_ != ( ss.sender.consecutive_retransmissions() > TCPConfig::MAX_RETX_ATTEMPTS ) ) {
       std::ostringstream desc;
       desc << "after " << ms_ << " ms passed the TCP Sender reported\n\tconsecutive_retransmissions = "
-           << ss.second.consecutive_retransmissions() << "\nbut it should have been\n\t";
+           << ss.sender.consecutive_retransmissions() << "\nbut it should have been\n\t";
       if ( max_retx_exceeded_.value() ) {
         desc << "greater than ";
       } else {
@@ -169,9 +182,9 @@ struct Receive : public Action<StreamAndSender>
 
   void execute( StreamAndSender& ss ) const override
   {
-    ss.second.receive( msg_ );
+    ss.sender.receive( msg_ );
     if ( push_ ) {
-      ss.second.push( ss.first.reader() );
+      ss.sender.push( ss.stream.reader() );
     }
   }
 
@@ -182,6 +195,17 @@ struct Receive : public Action<StreamAndSender>
   }
 };
 
+// Move the sender out and back again, as a container of senders might when it grows
+struct MoveSender : public Action<StreamAndSender>
+{
+  std::string description() const override { return "move the TCPSender"; }
+  void execute( StreamAndSender& ss ) const override
+  {
+    TCPSender moved { std::move( ss.sender ) };
+    ss.sender = std::move( moved );
+  }
+};
+
 struct AckReceived : public Receive
 {
   explicit AckReceived( Wrap32 ackno ) : Receive( { ackno, DEFAULT_TEST_WINDOW } ) {}
@@ -272,7 +296,7 @@ struct ExpectMessage : public Expectation<StreamAndSender>
       throw std::runtime_error( "inconsistent test: invalid ExpectMessage" );
     }
 
-    const auto maybe_seg = ss.second.maybe_send();
+    const auto maybe_seg = ss.sender.maybe_send();
     if ( not maybe_seg.has_value() ) {
       throw ExpectationViolation( "expected a message, but none was sent" );
     }
@@ -303,10 +327,23 @@ struct ExpectMessage : public Expectation<StreamAndSender>
 
 class TCPSenderTestHarness : public TestHarness<StreamAndSender>
 {
+  static StreamAndSender make( const TCPConfig& config, bool use_timers )
+  {
+    StreamAndSender ss {
+      {}, ByteStream { config.send_capacity }, TCPSender { config.rt_timeout, config.fixed_isn } };
+    if ( use_timers ) {
+      ss.timers = std::make_unique<RetransmissionTimers>();
+      ss.sender.use_timers( *ss.timers );
+    }
+    return ss;
+  }
+
 public:
-  TCPSenderTestHarness( std::string name, TCPConfig config )
+  // With `use_timers`, the sender keeps time in RetransmissionTimers rather than through its tick()
+  TCPSenderTestHarness( std::string name, TCPConfig config, bool use_timers = false )
     : TestHarness( move( name ),
-                   "initial_RTO_ms=" + to_string( config.rt_timeout ),
-                   { ByteStream { config.send_capacity }, TCPSender { config.rt_timeout, config.fixed_isn } } )
+                   "initial_RTO_ms=" + to_string( config.rt_timeout )
+                     + ( use_timers ? " in RetransmissionTimers" : "" ),
+                   make( config, use_timers ) )
   {}
 };
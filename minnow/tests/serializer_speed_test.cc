@@ -0,0 +1,134 @@
+#include "arp_message.hh"
+#include "ethernet_header.hh"
+#include "ipv4_datagram.hh"
+#include "network_interface.hh"
+#include "parser.hh"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+
+using namespace std;
+using namespace std::chrono;
+
+// Count every heap allocation made by the program
+namespace {
+size_t n_allocations = 0;
+}
+
+void* operator new( size_t size )
+{
+  n_allocations++;
+  if ( void* p = malloc( size ) ) { // NOLINT(*-no-malloc, *-owning-memory)
+    return p;
+  }
+  throw bad_alloc();
+}
+
+void operator delete( void* p ) noexcept
+{
+  free( p ); // NOLINT(*-no-malloc, *-owning-memory)
+}
+
+void operator delete( void* p, size_t /* size */ ) noexcept
+{
+  free( p ); // NOLINT(*-no-malloc, *-owning-memory)
+}
+
+namespace {
+
+constexpr size_t n_iterations = 1 << 18;
+
+// Run `f` repeatedly; report heap allocations and nanoseconds per run
+template<typename F>
+void measure( const string& name, F&& f )
+{
+  f(); // warm up (e.g. let queues reach their steady-state size)
+
+  const size_t allocations_before = n_allocations;
+  const auto start_time = steady_clock::now();
+  for ( size_t i = 0; i < n_iterations; i++ ) {
+    f();
+  }
+  const auto stop_time = steady_clock::now();
+
+  const double allocations = static_cast<double>( n_allocations - allocations_before ) / n_iterations;
+  const double ns = duration_cast<duration<double, nano>>( stop_time - start_time ).count() / n_iterations;
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << name << ": " << fixed << setprecision( 1 ) << allocations << " allocations, " << ns << " ns.\n";
+  debug_output << "      " << name << ": " << fixed << setprecision( 1 ) << allocations << " allocations/op, "
+               << ns << " ns/op\n";
+}
+
+} // namespace
+
+void program_body()
+{
+  InternetDatagram dgram;
+  dgram.header.src = 0x0a000001;
+  dgram.header.dst = 0x0a000002;
+  dgram.payload.emplace_back( string( 1400, 'x' ) );
+  dgram.header.len = IPv4Header::LENGTH + 1400;
+  dgram.header.compute_checksum();
+
+  measure( "IPv4Header::compute_checksum", [&] {
+    dgram.header.ttl--;
+    dgram.header.compute_checksum();
+  } );
+
+  measure( "serialize( IPv4Datagram )", [&] {
+    if ( serialize( dgram ).empty() ) {
+      throw runtime_error( "unexpected serialization" );
+    }
+  } );
+
+  // A header in front of a freshly filled payload lands in the payload's headroom
+  measure( "IPv4 header + fresh payload", [&] {
+    array<char, IPv4Header::LENGTH> headroom {};
+    Serializer serializer { headroom };
+    dgram.header.serialize( serializer );
+    serializer.buffer( Buffer::uninitialized( 1400, Buffer::HEADROOM ) );
+    if ( serializer.output().size() != 1 ) {
+      throw runtime_error( "header was not prepended to the payload" );
+    }
+  } );
+
+  // Frames through a NetworkInterface with a resolved next hop
+  NetworkInterface interface { { 2, 0, 0, 0, 0, 1 }, Address::from_ipv4_numeric( 0x0a000001 ) };
+  const Address next_hop = Address::from_ipv4_numeric( 0x0a000002 );
+  interface.add_static_neighbor( next_hop, { 2, 0, 0, 0, 0, 2 } );
+  measure( "NetworkInterface IPv4 frame", [&] {
+    interface.send_datagram( dgram, next_hop );
+    if ( not interface.maybe_send().has_value() ) {
+      throw runtime_error( "no frame sent" );
+    }
+  } );
+
+  measure( "NetworkInterface ARP frame", [&] {
+    interface.announce();
+    if ( not interface.maybe_send().has_value() ) {
+      throw runtime_error( "no frame sent" );
+    }
+  } );
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,136 @@
+#include "network_simulator.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <tuple>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+
+constexpr SimTime simulated_time = 120'000'000; // two minutes
+
+struct Outcome
+{
+  uint64_t bytes_delivered {};
+  SimulatedLink::Stats bottleneck {};
+  uint64_t events {};
+
+  bool operator==( const Outcome& other ) const
+  {
+    return tie( bytes_delivered, bottleneck.frames_sent, bottleneck.queue_drops, bottleneck.losses, events )
+           == tie( other.bytes_delivered,
+                   other.bottleneck.frames_sent,
+                   other.bottleneck.queue_drops,
+                   other.bottleneck.losses,
+                   other.events );
+  }
+};
+
+// A bulk transfer from host A to host B through a router, with a 10 Mbit/s lossy bottleneck:
+//
+//   A ==(1 Gbit/s, 1 ms)== R --(10 Mbit/s, 20 ms, 0.1% loss, `queue_depth` frames)-- B
+Outcome simulate( uint64_t seed, size_t queue_depth )
+{
+  Simulator sim { seed };
+
+  SimulatedLink& access = sim.add_link( { 1'000'000'000, 1000, 0, 1000 } );
+  SimulatedLink& bottleneck = sim.add_link( { 10'000'000, 20'000, 0.001, queue_depth } );
+
+  TCPConfig config;
+  config.rt_timeout = 200;
+  SimulatedHost& a = sim.add_host( { 2, 0, 0, 0, 0, 0xa }, Address { "10.0.0.2" }, Address { "10.0.0.1" }, config );
+  SimulatedHost& b = sim.add_host( { 2, 0, 0, 0, 0, 0xb }, Address { "10.0.1.2" }, Address { "10.0.1.1" }, config );
+  a.connect( access, 0 );
+  b.connect( bottleneck, 1 );
+
+  SimulatedRouter& router = sim.add_router();
+  const size_t to_a = router.add_interface( { 2, 0, 0, 0, 0, 1 }, Address { "10.0.0.1" }, access, 1 );
+  const size_t to_b = router.add_interface( { 2, 0, 0, 0, 0, 2 }, Address { "10.0.1.1" }, bottleneck, 0 );
+  router.add_route( Address { "10.0.0.0" }.ipv4_numeric(), 24, {}, to_a );
+  router.add_route( Address { "10.0.1.0" }.ipv4_numeric(), 24, {}, to_b );
+
+  // A keeps its outbound stream full; B reads everything that arrives
+  const string chunk( 16384, 'x' );
+  a.open( Address { "10.0.1.2" }, [&chunk]( TCPPeer& peer ) {
+    Writer& writer = peer.outbound_writer();
+    while ( writer.available_capacity() > 0 ) {
+      writer.push( chunk.substr( 0, min( chunk.size(), writer.available_capacity() ) ) );
+    }
+  } );
+
+  Outcome outcome;
+  b.open( Address { "10.0.0.2" }, [&outcome]( TCPPeer& peer ) {
+    Reader& reader = peer.inbound_reader();
+    while ( reader.bytes_buffered() > 0 ) {
+      const size_t len = reader.peek().size();
+      reader.pop( len );
+      outcome.bytes_delivered += len;
+    }
+  } );
+
+  sim.run_until( simulated_time );
+  outcome.bottleneck = bottleneck.stats( 0 );
+  outcome.events = sim.events_run();
+  return outcome;
+}
+
+void speed_test( size_t queue_depth )
+{
+  const auto start_time = steady_clock::now();
+  const Outcome outcome = simulate( 42, queue_depth );
+  const auto stop_time = steady_clock::now();
+
+  if ( not( simulate( 42, queue_depth ) == outcome ) ) {
+    throw runtime_error( "two runs with the same seed came out differently" );
+  }
+  if ( outcome.bytes_delivered == 0 ) {
+    throw runtime_error( "nothing was delivered" );
+  }
+
+  const double wall_seconds = duration_cast<duration<double>>( stop_time - start_time ).count();
+  const double simulated_seconds = static_cast<double>( simulated_time ) / 1e6;
+  const double goodput_mbps = static_cast<double>( outcome.bytes_delivered ) * 8 / simulated_seconds / 1e6;
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "Simulated " << simulated_time / 1'000'000 << " s of a bulk transfer over a 10 Mbit/s bottleneck with a "
+       << queue_depth << "-frame queue in " << fixed << setprecision( 2 ) << wall_seconds << " s ("
+       << setprecision( 0 ) << simulated_seconds / wall_seconds << "x real time, " << outcome.events
+       << " events): " << setprecision( 2 ) << goodput_mbps << " Mbit/s goodput, "
+       << outcome.bottleneck.frames_sent << " frames across the bottleneck, " << outcome.bottleneck.queue_drops
+       << " dropped by its queue, " << outcome.bottleneck.losses
+       << " lost. A second run with the same seed matched.\n";
+
+  debug_output << "      simulator (" << queue_depth << "-frame queue): " << fixed << setprecision( 0 )
+               << simulated_seconds / wall_seconds << "x real time, " << setprecision( 2 ) << goodput_mbps
+               << " Mbit/s simulated goodput\n";
+}
+
+} // namespace
+
+void program_body()
+{
+  // A queue deep enough for the whole 64 kB window, and one that is not: without congestion control, the
+  // sender overruns it and then recovers one segment per timeout
+  speed_test( 64 );
+  speed_test( 32 );
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
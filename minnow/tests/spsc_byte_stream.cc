@@ -0,0 +1,211 @@
+#include "spsc_byte_stream.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+
+void expect( bool condition, const string& what )
+{
+  if ( not condition ) {
+    throw runtime_error( "SPSCByteStream: expected " + what );
+  }
+}
+
+// The i'th byte of the test data
+char byte_at( uint64_t i )
+{
+  return static_cast<char>( i * 7 + i / 251 );
+}
+
+string bytes_from( uint64_t first, uint64_t len )
+{
+  string data;
+  for ( uint64_t i = first; i < first + len; i++ ) {
+    data.push_back( byte_at( i ) );
+  }
+  return data;
+}
+
+// Pop everything buffered (in as many peeks as the ring's end takes), and check that it is what was pushed
+void drain( SPSCByteStream& stream )
+{
+  while ( stream.bytes_buffered() > 0 ) {
+    const uint64_t first = stream.bytes_popped();
+    const string_view peeked = stream.peek();
+    expect( not peeked.empty(), "something to peek while bytes are buffered" );
+    expect( peeked == bytes_from( first, peeked.size() ), "the bytes pushed, in order" );
+    stream.pop( peeked.size() );
+  }
+}
+
+// A capacity that is not a power of two, so the ring is larger than the capacity, and pushes and pops that
+// wrap around the end of the ring many times
+void wrap_around()
+{
+  SPSCByteStream stream { 5 };
+  expect( stream.capacity() == 5, "the capacity asked for" );
+  expect( stream.push( bytes_from( 0, 8 ) ) == 5, "a push to be cut to the capacity, not the ring's size" );
+  expect( stream.available_capacity() == 0 and stream.push( "x" ) == 0, "a full stream to take nothing" );
+  expect( stream.peek() == bytes_from( 0, 5 ), "the first bytes" );
+
+  default_random_engine rd { 1 };
+  uint64_t pushed = 5;
+  for ( size_t i = 0; i < 10000; i++ ) {
+    const uint64_t pop_len = rd() % ( stream.bytes_buffered() + 1 );
+    uint64_t popped = 0;
+    while ( popped < pop_len ) {
+      const string_view peeked = stream.peek();
+      const uint64_t len = min<uint64_t>( peeked.size(), pop_len - popped );
+      expect( peeked.substr( 0, len ) == bytes_from( stream.bytes_popped(), len ), "the bytes pushed, in order" );
+      stream.pop( len );
+      popped += len;
+    }
+
+    const uint64_t room = stream.available_capacity();
+    expect( room + stream.bytes_buffered() == 5, "the capacity to bound what is buffered" );
+    const uint64_t push_len = rd() % 7;
+    expect( stream.push( bytes_from( pushed, push_len ) ) == min( push_len, room ), "as much pushed as fits" );
+    pushed += min( push_len, room );
+    expect( stream.bytes_pushed() == pushed, "bytes_pushed to count what was taken" );
+  }
+
+  stream.close();
+  expect( not stream.is_finished(), "not finished while bytes are buffered" );
+  drain( stream );
+  expect( stream.is_finished(), "finished once closed and drained" );
+}
+
+void zero_capacity()
+{
+  SPSCByteStream stream { 0 };
+  expect( stream.push( "abc" ) == 0, "nothing pushed" );
+  expect( stream.push( "" ) == 0, "an empty push to be harmless" );
+  expect( stream.available_capacity() == 0 and stream.bytes_buffered() == 0, "no room and nothing buffered" );
+  expect( stream.peek().empty(), "nothing to peek" );
+  stream.pop( 0 );
+  stream.close();
+  expect( stream.is_finished(), "a closed empty stream to be finished" );
+}
+
+void pop_too_much()
+{
+  SPSCByteStream stream { 16 };
+  stream.push( "hello" );
+  bool threw = false;
+  try {
+    stream.pop( 6 );
+  } catch ( const runtime_error& ) {
+    threw = true;
+  }
+  expect( threw, "popping more than is buffered to throw" );
+  expect( stream.bytes_popped() == 0 and stream.peek() == "hello", "a failed pop to leave the stream alone" );
+  stream.pop( 5 );
+  expect( stream.bytes_buffered() == 0, "the right amount to pop" );
+}
+
+// Give a thread time to go to sleep, so that what follows has to wake it
+void let_it_sleep()
+{
+  this_thread::sleep_for( milliseconds { 50 } );
+}
+
+// With no room (capacity 0), and so nothing to read either, a reader and a writer both sleep until an error
+void error_wakes_both()
+{
+  SPSCByteStream stream { 0 };
+  bool reader_woke = false;
+  bool writer_woke = false;
+  thread reader { [&] {
+    stream.wait_readable();
+    reader_woke = true;
+  } };
+  thread writer { [&] {
+    stream.wait_writable();
+    writer_woke = true;
+  } };
+  let_it_sleep();
+  stream.set_error();
+  reader.join();
+  writer.join();
+  expect( reader_woke and writer_woke and stream.has_error(), "both sides woken by the error" );
+}
+
+void close_wakes_reader()
+{
+  SPSCByteStream stream { 16 };
+  bool finished = false;
+  thread reader { [&] {
+    stream.wait_readable();
+    finished = stream.is_finished();
+  } };
+  let_it_sleep();
+  stream.close();
+  reader.join();
+  expect( finished, "the reader woken by the close, to a finished stream" );
+}
+
+// A writer and a reader on their own threads, each sleeping when the other falls behind
+void two_threads()
+{
+  constexpr uint64_t total = 1 << 20;
+  SPSCByteStream stream { 1000 };
+
+  thread writer { [&] {
+    default_random_engine rd { 2 };
+    uint64_t pushed = 0;
+    while ( pushed < total ) {
+      stream.wait_writable();
+      pushed += stream.push( bytes_from( pushed, min<uint64_t>( rd() % 3000, total - pushed ) ) );
+    }
+    stream.close();
+  } };
+
+  uint64_t mismatches = 0;
+  thread reader { [&] {
+    while ( true ) {
+      stream.wait_readable();
+      if ( stream.is_finished() ) {
+        break;
+      }
+      const uint64_t first = stream.bytes_popped();
+      const string_view peeked = stream.peek();
+      mismatches += peeked != bytes_from( first, peeked.size() );
+      stream.pop( peeked.size() );
+    }
+  } };
+
+  writer.join();
+  reader.join();
+  expect( mismatches == 0, "the reader to see the bytes pushed, in order" );
+  expect( stream.bytes_popped() == total and stream.is_finished(), "everything to arrive" );
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    wrap_around();
+    zero_capacity();
+    pop_too_much();
+    error_wakes_both();
+    close_wakes_reader();
+    two_threads();
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
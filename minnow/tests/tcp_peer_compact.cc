@@ -0,0 +1,138 @@
+#include "tcp_peer.hh"
+
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <malloc.h>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+// Track the bytes the program has live on the heap
+namespace {
+size_t live_bytes = 0;
+
+// Kept out of line, so the compiler does not pair each inlined free() with the operator new it came from
+[[gnu::noinline]] void release( void* p )
+{
+  live_bytes -= malloc_usable_size( p );
+  free( p ); // NOLINT(*-no-malloc, *-owning-memory)
+}
+} // namespace
+
+void* operator new( size_t size )
+{
+  if ( void* p = malloc( size ) ) { // NOLINT(*-no-malloc, *-owning-memory)
+    live_bytes += malloc_usable_size( p );
+    return p;
+  }
+  throw bad_alloc();
+}
+
+void operator delete( void* p ) noexcept
+{
+  release( p );
+}
+
+void operator delete( void* p, size_t /* size */ ) noexcept
+{
+  release( p );
+}
+
+namespace {
+
+constexpr uint64_t idle_ms = 100;
+
+// Takes a plain string, so that building its argument does not change live_bytes before the comparison
+void expect( bool condition, const char* what )
+{
+  if ( not condition ) {
+    throw runtime_error( string { "TCPPeer: expected " } + what );
+  }
+}
+
+// Carry segments both ways until neither peer has anything more to send
+void exchange( TCPPeer& a, TCPPeer& b )
+{
+  bool sent = true;
+  while ( sent ) {
+    sent = false;
+    while ( auto message = a.maybe_send() ) {
+      b.receive( move( *message ) );
+      sent = true;
+    }
+    while ( auto message = b.maybe_send() ) {
+      a.receive( move( *message ) );
+      sent = true;
+    }
+  }
+}
+
+// A reader that drains the inbound stream only after the connection has gone idle still gets its buffers
+// released
+void slow_reader()
+{
+  TCPConfig cfg;
+  cfg.idle_compact_ms = idle_ms;
+  TCPPeer client { cfg };
+  TCPPeer server { cfg };
+
+  client.outbound_writer().push( string( 3000, 'x' ) );
+  client.push();
+  exchange( client, server );
+  expect( server.inbound_reader().bytes_buffered() == 3000, "the data to arrive" );
+
+  // Idle, but the data is still unread, so the inbound stream is kept (and so is its data)
+  server.tick( idle_ms - 1 );
+  const size_t before_threshold = live_bytes;
+  server.tick( 1 );
+  const size_t at_threshold = live_bytes;
+  expect( at_threshold < before_threshold, "the empty buffers to be released at the idle threshold" );
+  expect( server.inbound_reader().bytes_buffered() == 3000, "unread data to be kept" );
+
+  server.tick( idle_ms );
+  expect( live_bytes == at_threshold, "nothing more to release while the data is unread" );
+
+  // Read everything well past the threshold; the next tick releases the stream
+  string read;
+  while ( server.inbound_reader().bytes_buffered() > 0 ) {
+    const string_view chunk = server.inbound_reader().peek();
+    read += chunk;
+    server.inbound_reader().pop( chunk.size() );
+  }
+  expect( read == string( 3000, 'x' ), "the data to survive compaction attempts" );
+  const size_t after_reading = live_bytes;
+  server.tick( 1 );
+  expect( live_bytes < after_reading, "the drained stream to be released on the next tick" );
+
+  const size_t compacted = live_bytes;
+  server.tick( idle_ms );
+  expect( live_bytes == compacted, "nothing left to release" );
+
+  // New data makes the connection busy again, and it is compacted once more when it next goes idle
+  client.outbound_writer().push( "more" );
+  client.push();
+  exchange( client, server );
+  server.inbound_reader().pop( server.inbound_reader().bytes_buffered() );
+  const size_t busy = live_bytes;
+  server.tick( idle_ms - 1 );
+  expect( live_bytes == busy, "no compaction before the connection has been idle long enough" );
+  server.tick( 1 );
+  expect( live_bytes < busy, "compaction once the connection is idle again" );
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    slow_reader();
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
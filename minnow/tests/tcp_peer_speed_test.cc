@@ -0,0 +1,119 @@
+#include "tcp_peer.hh"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+
+constexpr size_t bytes_each_way = 512UL << 20; // 1 GiB in all
+constexpr size_t write_size = 16384;
+
+// One direction of the transfer, from the application's point of view
+struct Transfer
+{
+  size_t written {};
+  size_t read {};
+};
+
+void write_some( TCPPeer& peer, Transfer& transfer, const string& chunk )
+{
+  Writer& writer = peer.outbound_writer();
+  while ( transfer.written < bytes_each_way and writer.available_capacity() > 0 ) {
+    const size_t len = min( { chunk.size(), writer.available_capacity(), bytes_each_way - transfer.written } );
+    writer.push( chunk.substr( 0, len ) );
+    transfer.written += len;
+  }
+  if ( transfer.written == bytes_each_way and not writer.is_closed() ) {
+    writer.close();
+  }
+  peer.push();
+}
+
+void read_all( TCPPeer& peer, Transfer& transfer )
+{
+  Reader& reader = peer.inbound_reader();
+  while ( reader.bytes_buffered() > 0 ) {
+    const size_t len = reader.peek().size();
+    reader.pop( len );
+    transfer.read += len;
+  }
+}
+
+// Deliver everything `from` has to send to `to`; returns how many segments that was, and how many of them
+// carried nothing but an acknowledgment or window update
+pair<size_t, size_t> deliver( TCPPeer& from, TCPPeer& to )
+{
+  size_t segments = 0;
+  size_t bare_acks = 0;
+  while ( auto message = from.maybe_send() ) {
+    segments++;
+    bare_acks += message->sender.sequence_length() == 0;
+    to.receive( move( *message ) );
+  }
+  return { segments, bare_acks };
+}
+
+void speed_test()
+{
+  TCPConfig config;
+  config.fixed_isn = Wrap32 { 12345 };
+  array<TCPPeer, 2> peers { TCPPeer { config }, TCPPeer { config } };
+  array<Transfer, 2> transfers {}; // transfers[i] goes from peers[i] to the other one
+  const string chunk( write_size, 'x' );
+
+  size_t segments = 0;
+  size_t bare_acks = 0;
+  const auto start_time = steady_clock::now();
+  while ( peers[0].active() or peers[1].active() ) {
+    for ( size_t i = 0; i < 2; i++ ) {
+      write_some( peers[i], transfers[i], chunk );
+    }
+    for ( size_t i = 0; i < 2; i++ ) {
+      const auto [sent, acks] = deliver( peers[i], peers[1 - i] );
+      segments += sent;
+      bare_acks += acks;
+      read_all( peers[1 - i], transfers[i] );
+    }
+  }
+  const auto stop_time = steady_clock::now();
+
+  for ( const auto& transfer : transfers ) {
+    if ( transfer.read != bytes_each_way ) {
+      throw runtime_error( "transfer ended after " + to_string( transfer.read ) + " bytes" );
+    }
+  }
+
+  const double seconds = duration_cast<duration<double>>( stop_time - start_time ).count();
+  const double gigabits_per_second = 2 * bytes_each_way * 8 / seconds / 1e9;
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "Two TCPPeers, " << ( bytes_each_way >> 20 ) << " MiB each way: " << fixed << setprecision( 2 )
+       << gigabits_per_second << " Gbit/s, " << segments << " segments (" << bare_acks << " bare acks).\n";
+
+  debug_output << "      TCPPeer transfer: " << fixed << setprecision( 2 ) << gigabits_per_second << " Gbit/s, "
+               << segments << " segments (" << bare_acks << " bare acks)\n";
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    speed_test();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
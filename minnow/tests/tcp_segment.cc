@@ -0,0 +1,166 @@
+#include "tcp_segment.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+namespace {
+
+constexpr uint32_t src = 0x0a000001;
+constexpr uint32_t dst = 0x0a000002;
+
+void expect( bool condition, const string& what )
+{
+  if ( not condition ) {
+    throw runtime_error( "TCPSegment: expected " + what );
+  }
+}
+
+TCPSegment make_segment( string options, string payload )
+{
+  TCPSegment segment;
+  segment.src_port = 40000;
+  segment.dst_port = 443;
+  segment.options = std::move( options );
+  segment.message.sender.seqno = Wrap32 { 0xfffffff0 };
+  segment.message.sender.SYN = true;
+  segment.message.sender.payload = Buffer { std::move( payload ) };
+  segment.message.receiver.ackno = Wrap32 { 12345 };
+  segment.message.receiver.window_size = 64000;
+  return segment;
+}
+
+// `datagram`, with its TCP segment replaced by `bytes`
+IPv4Datagram with_payload( IPv4Datagram datagram, string bytes )
+{
+  datagram.payload = { Buffer { std::move( bytes ) } };
+  return datagram;
+}
+
+void round_trip()
+{
+  const TCPSegment segment = make_segment( {}, "hello, world" );
+  const IPv4Datagram datagram = segment.to_datagram( src, dst );
+
+  TCPSegment parsed;
+  expect( parsed.parse_datagram( datagram ), "a serialized segment to parse" );
+  expect( parsed.src_port == 40000 and parsed.dst_port == 443, "the ports to survive the round trip" );
+  expect( parsed.message.sender.seqno == Wrap32 { 0xfffffff0 }, "the seqno to survive the round trip" );
+  expect( parsed.message.sender.SYN and not parsed.message.sender.FIN and not parsed.RST,
+          "the flags to survive the round trip" );
+  expect( parsed.message.receiver.ackno == Wrap32 { 12345 }, "the ackno to survive the round trip" );
+  expect( parsed.message.receiver.window_size == 64000, "the window to survive the round trip" );
+  expect( string_view { parsed.message.sender.payload } == "hello, world",
+          "the payload to survive the round trip" );
+  expect( parsed.options.empty(), "no options" );
+
+  // No ACK flag means no ackno, and RST and FIN come through too
+  TCPSegment reset = make_segment( {}, {} );
+  reset.message.sender.SYN = false;
+  reset.message.sender.FIN = true;
+  reset.message.receiver.ackno.reset();
+  reset.RST = true;
+  expect( parsed.parse_datagram( reset.to_datagram( src, dst ) ), "a segment without ACK to parse" );
+  expect( not parsed.message.receiver.ackno.has_value(), "no ackno without the ACK flag" );
+  expect( parsed.RST and parsed.message.sender.FIN and not parsed.message.sender.SYN,
+          "RST and FIN to survive the round trip" );
+  expect( parsed.message.sender.payload.empty(), "an empty payload" );
+
+  // The segment may arrive split across several Buffers
+  const string bytes = datagram.payload.concatenate();
+  IPv4Datagram split = datagram;
+  split.payload
+    = { Buffer { bytes.substr( 0, 7 ) }, Buffer { bytes.substr( 7, 20 ) }, Buffer { bytes.substr( 27 ) } };
+  expect( parsed.parse_datagram( split ), "a segment split across Buffers to parse" );
+  expect( string_view { parsed.message.sender.payload } == "hello, world", "the payload of a split segment" );
+
+  // Only TCP is parsed as TCP
+  IPv4Datagram udp = datagram;
+  udp.header.proto = 17;
+  expect( not parsed.parse_datagram( udp ), "a UDP datagram to be refused" );
+}
+
+void bad_checksum()
+{
+  const IPv4Datagram datagram = make_segment( {}, "hello, world" ).to_datagram( src, dst );
+  const string bytes = datagram.payload.concatenate();
+  TCPSegment parsed;
+
+  // A bit flipped anywhere, in the header or the payload, or a different pseudo-header
+  for ( const size_t i : { size_t { 0 }, size_t { 4 }, size_t { 16 }, bytes.size() - 1 } ) {
+    string corrupted = bytes;
+    corrupted[i] ^= 1;
+    expect( not parsed.parse_datagram( with_payload( datagram, corrupted ) ),
+            "a corrupted segment to be refused (byte " + to_string( i ) + ")" );
+  }
+
+  IPv4Datagram misaddressed = datagram;
+  misaddressed.header.dst = dst + 1;
+  expect( not parsed.parse_datagram( misaddressed ), "a segment for another address to be refused" );
+}
+
+void options_skipped()
+{
+  const string options { "\x02\x04\x05\xb4\x01\x03\x03\x07\x01\x01\x04\x02", 12 }; // MSS, NOP, WS, NOP x2, SACK
+  const TCPSegment segment = make_segment( options, "payload after the options" );
+  expect( segment.header_length() == 32, "the options to count in the header length" );
+
+  const IPv4Datagram datagram = segment.to_datagram( src, dst );
+  expect( datagram.payload.length() == 32 + 25, "the options to be serialized" );
+
+  TCPSegment parsed;
+  expect( parsed.parse_datagram( datagram ), "a segment with options to parse" );
+  expect( parsed.options == options, "the options to be kept as they were" );
+  expect( string_view { parsed.message.sender.payload } == "payload after the options",
+          "the payload to start after the options" );
+
+  // Options must be whole words, and fit in the data offset
+  TCPSegment ragged = make_segment( string( 3, '\x01' ), {} );
+  bool threw = false;
+  try {
+    (void)ragged.to_datagram( src, dst );
+  } catch ( const runtime_error& ) {
+    threw = true;
+  }
+  expect( threw, "options that are not a multiple of four bytes to be refused" );
+}
+
+void truncated()
+{
+  const IPv4Datagram datagram
+    = make_segment( string { "\x02\x04\x05\xb4", 4 }, "hello, world" ).to_datagram( src, dst );
+  const string bytes = datagram.payload.concatenate();
+  TCPSegment parsed;
+
+  expect( not parsed.parse_datagram( with_payload( datagram, {} ) ), "an empty segment to be refused" );
+  expect( not parsed.parse_datagram( with_payload( datagram, bytes.substr( 0, TCPSegment::LENGTH - 1 ) ) ),
+          "a segment shorter than the fixed header to be refused" );
+  expect( not parsed.parse_datagram( with_payload( datagram, bytes.substr( 0, TCPSegment::LENGTH + 2 ) ) ),
+          "a segment cut off in its options to be refused" );
+
+  // A data offset below five words
+  string short_offset = bytes;
+  short_offset[12] = 0x40;
+  expect( not parsed.parse_datagram( with_payload( datagram, short_offset ) ),
+          "a data offset of four to be refused" );
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    round_trip();
+    bad_checksum();
+    options_skipped();
+    truncated();
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
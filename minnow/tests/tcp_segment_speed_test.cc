@@ -0,0 +1,128 @@
+#include "tcp_segment.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+
+constexpr size_t n_iterations = 1 << 18;
+constexpr uint32_t src = 0x0a000001;
+constexpr uint32_t dst = 0x0a000002;
+
+template<typename F>
+double time_ns( F&& f )
+{
+  const auto start_time = steady_clock::now();
+  for ( size_t i = 0; i < n_iterations; i++ ) {
+    f();
+  }
+  const auto stop_time = steady_clock::now();
+  return duration_cast<duration<double, nano>>( stop_time - start_time ).count() / n_iterations;
+}
+
+// Check the checksum the long way: over the flattened segment and the pseudo-header
+void check_checksum( const IPv4Datagram& datagram )
+{
+  InternetChecksum check { datagram.header.pseudo_checksum() };
+  check.add( datagram.payload.concatenate() );
+  if ( check.value() != 0 ) {
+    throw runtime_error( "TCP checksum is wrong" );
+  }
+}
+
+TCPSegment make_segment( size_t payload_size, bool known_sum )
+{
+  TCPSegment segment;
+  segment.src_port = 40000;
+  segment.dst_port = 443;
+  segment.options = string { "\x02\x04\x05\xb4", 4 }; // MSS
+  segment.message.sender.seqno = Wrap32 { 0xfffffff0 };
+  segment.message.sender.FIN = true;
+  segment.message.receiver.ackno = Wrap32 { 12345 };
+  segment.message.receiver.window_size = 64000;
+
+  string payload( payload_size, 0 );
+  for ( size_t i = 0; i < payload.size(); i++ ) {
+    payload[i] = static_cast<char>( i * 13 + 1 );
+  }
+  InternetChecksum sum;
+  segment.message.sender.payload = Buffer::copy_of( payload );
+  sum.add( segment.message.sender.payload );
+  if ( known_sum ) {
+    segment.message.sender.payload_sum = sum.sum();
+  }
+  return segment;
+}
+
+void speed_test( size_t payload_size )
+{
+  const TCPSegment with_sum = make_segment( payload_size, true );
+  const TCPSegment without_sum = make_segment( payload_size, false );
+
+  const IPv4Datagram datagram = with_sum.to_datagram( src, dst );
+  check_checksum( datagram );
+  if ( without_sum.to_datagram( src, dst ).payload.concatenate() != datagram.payload.concatenate() ) {
+    throw runtime_error( "payload_sum changed the serialized segment" );
+  }
+
+  // Round trip, and a corrupted copy must be refused
+  TCPSegment parsed;
+  if ( not parsed.parse_datagram( datagram ) or parsed.message.sender.seqno != with_sum.message.sender.seqno
+       or parsed.message.receiver.ackno != with_sum.message.receiver.ackno or not parsed.message.sender.FIN
+       or parsed.options != with_sum.options or parsed.dst_port != with_sum.dst_port
+       or string_view { parsed.message.sender.payload } != string_view { with_sum.message.sender.payload } ) {
+    throw runtime_error( "TCP segment did not survive the round trip" );
+  }
+  IPv4Datagram corrupted = datagram;
+  string flipped = corrupted.payload.concatenate();
+  flipped.back() ^= 1;
+  corrupted.payload = { Buffer { flipped } };
+  if ( parsed.parse_datagram( corrupted ) ) {
+    throw runtime_error( "corrupted TCP segment was accepted" );
+  }
+
+  const double with_sum_ns = time_ns( [&] { (void)with_sum.to_datagram( src, dst ); } );
+  const double without_sum_ns = time_ns( [&] { (void)without_sum.to_datagram( src, dst ); } );
+  const double parse_ns = time_ns( [&] {
+    if ( not parsed.parse_datagram( datagram ) ) {
+      throw runtime_error( "failed to parse TCP segment" );
+    }
+  } );
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "TCP segment with " << payload_size << "-byte payload: " << fixed << setprecision( 1 ) << with_sum_ns
+       << " ns to serialize with payload_sum, " << without_sum_ns << " ns without, " << parse_ns
+       << " ns to parse.\n";
+
+  debug_output << "      TCPSegment (" << payload_size << " B): " << fixed << setprecision( 1 ) << with_sum_ns
+               << " ns serialize (" << without_sum_ns << " ns summing the payload), " << parse_ns << " ns parse\n";
+}
+
+} // namespace
+
+void program_body()
+{
+  speed_test( 0 );
+  speed_test( 1000 );
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,228 @@
+#include "eventloop.hh"
+#include "tcp_over_udp.hh"
+#include "tcp_peer.hh"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <sys/resource.h>
+#include <thread>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+
+constexpr auto give_up_after = seconds { 120 };
+
+struct Stats
+{
+  size_t segments {};
+  size_t retransmissions {};
+  size_t bytes_delivered {};
+};
+
+// Joins a thread when it goes out of scope, however the scope is left, after telling it to stop
+class JoinGuard
+{
+  thread& thread_;
+  atomic<bool>& stop_;
+
+public:
+  JoinGuard( thread& t, atomic<bool>& stop ) : thread_( t ), stop_( stop ) {}
+  JoinGuard( const JoinGuard& other ) = delete;
+  JoinGuard& operator=( const JoinGuard& other ) = delete;
+
+  ~JoinGuard()
+  {
+    stop_ = true;
+    thread_.join();
+  }
+};
+
+// Drive `peer` over `adapter` from an EventLoop, calling `app` after every event so it can write to or read
+// from the peer's streams. Keeps going after the peer is done until the other end is done too, so the last
+// acknowledgments still get answered if they are lost, or until `stop` is set because the other end failed.
+void run_peer( TCPPeer& peer,
+               TCPOverUDPAdapter& adapter,
+               const TCPConfig& config,
+               const function<void()>& app,
+               atomic<int>& n_done,
+               const atomic<bool>& stop,
+               Stats& stats )
+{
+  EventLoop loop;
+  loop.add_rule( adapter.socket(), EventLoop::Direction::In, [&] {
+    while ( auto message = adapter.read() ) {
+      peer.receive( move( *message ) );
+    }
+  } );
+
+  auto last_tick = steady_clock::now();
+  loop.add_timer(
+    milliseconds { 1 },
+    [&] {
+      const auto elapsed = duration_cast<milliseconds>( steady_clock::now() - last_tick );
+      last_tick += elapsed;
+      peer.tick( elapsed.count() );
+      adapter.send_due();
+    },
+    true );
+
+  const Wrap32 isn = config.fixed_isn.value();
+  uint64_t next_new_seqno = 0; // absolute
+  bool done = false;
+  const auto deadline = steady_clock::now() + give_up_after;
+  while ( ( not done or n_done.load() < 2 ) and not stop.load() ) {
+    loop.wait_next_event( 1 );
+    app();
+    peer.push();
+
+    while ( auto message = peer.maybe_send() ) {
+      const TCPSenderMessage& sent = message->sender;
+      const uint64_t seqno = sent.seqno.unwrap( isn, next_new_seqno );
+      if ( sent.sequence_length() > 0 and seqno < next_new_seqno ) {
+        stats.retransmissions++;
+      }
+      next_new_seqno = max( next_new_seqno, seqno + sent.sequence_length() );
+      stats.segments++;
+      adapter.write( *message );
+    }
+
+    if ( not done and not peer.active() ) {
+      done = true;
+      n_done++;
+    }
+    if ( steady_clock::now() > deadline ) {
+      throw runtime_error( "transfer stalled" );
+    }
+  }
+}
+
+double cpu_seconds()
+{
+  rusage usage {};
+  getrusage( RUSAGE_SELF, &usage );
+  return static_cast<double>( usage.ru_utime.tv_sec + usage.ru_stime.tv_sec )
+         + static_cast<double>( usage.ru_utime.tv_usec + usage.ru_stime.tv_usec ) / 1e6;
+}
+
+// Send `n_bytes` one way through two peers in their own threads, over loopback UDP
+void speed_test( const string& name, size_t n_bytes, const Impairments& impairments )
+{
+  TCPConfig config;
+  config.rt_timeout = 20;
+  config.fixed_isn = Wrap32 { 0x1000 };
+
+  UDPSocket sender_socket;
+  UDPSocket receiver_socket;
+  sender_socket.bind( Address { "127.0.0.1" } );
+  receiver_socket.bind( Address { "127.0.0.1" } );
+  sender_socket.connect( receiver_socket.local_address() );
+  receiver_socket.connect( sender_socket.local_address() );
+  TCPOverUDPAdapter sender_adapter { move( sender_socket ), impairments };
+  TCPOverUDPAdapter receiver_adapter { move( receiver_socket ), impairments };
+
+  TCPPeer sender { config };
+  TCPPeer receiver { config };
+  Stats sender_stats;
+  Stats receiver_stats;
+  atomic<int> n_done = 0;
+
+  const string chunk( 16384, 'x' );
+  size_t written = 0;
+  auto write_app = [&] {
+    Writer& writer = sender.outbound_writer();
+    while ( written < n_bytes and writer.available_capacity() > 0 ) {
+      const size_t len = min( { chunk.size(), writer.available_capacity(), n_bytes - written } );
+      writer.push( chunk.substr( 0, len ) );
+      written += len;
+    }
+    if ( written == n_bytes and not writer.is_closed() ) {
+      writer.close();
+    }
+  };
+
+  receiver.outbound_writer().close(); // nothing to say in return
+  auto read_app = [&] {
+    Reader& reader = receiver.inbound_reader();
+    while ( reader.bytes_buffered() > 0 ) {
+      const size_t len = reader.peek().size();
+      reader.pop( len );
+      receiver_stats.bytes_delivered += len;
+    }
+  };
+
+  // An exception must not escape the receiver's thread (that would terminate the process), so it is carried
+  // back to this one. If the sender fails instead, the receiver is stopped and joined on the way out.
+  atomic<bool> sender_stopped = false;
+  atomic<bool> receiver_stopped = false;
+  exception_ptr receiver_error;
+
+  const double cpu_before = cpu_seconds();
+  const auto start_time = steady_clock::now();
+  {
+    thread receiver_thread { [&] {
+      try {
+        run_peer( receiver, receiver_adapter, config, read_app, n_done, receiver_stopped, receiver_stats );
+      } catch ( ... ) {
+        receiver_error = current_exception();
+        sender_stopped = true;
+      }
+    } };
+    const JoinGuard join { receiver_thread, receiver_stopped };
+    run_peer( sender, sender_adapter, config, write_app, n_done, sender_stopped, sender_stats );
+  }
+  const auto stop_time = steady_clock::now();
+  if ( receiver_error ) {
+    rethrow_exception( receiver_error );
+  }
+  const double cpu = cpu_seconds() - cpu_before;
+
+  if ( receiver_stats.bytes_delivered != n_bytes ) {
+    throw runtime_error( name + ": only " + to_string( receiver_stats.bytes_delivered ) + " bytes arrived" );
+  }
+
+  const double seconds = duration_cast<duration<double>>( stop_time - start_time ).count();
+  const double megabytes_per_second = static_cast<double>( n_bytes ) / seconds / 1e6;
+  const double cpu_ns_per_byte = cpu * 1e9 / static_cast<double>( n_bytes );
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  cout << "TCP over loopback UDP, " << name << ": " << fixed << setprecision( 1 ) << megabytes_per_second
+       << " MB/s goodput, " << sender_stats.segments << " segments with " << sender_stats.retransmissions
+       << " retransmissions, " << receiver_stats.segments << " segments back, "
+       << sender_adapter.dropped() + receiver_adapter.dropped() << " dropped for want of socket buffer, "
+       << setprecision( 2 ) << cpu_ns_per_byte << " ns CPU per byte.\n";
+
+  debug_output << "      TCP over UDP (" << name << "): " << fixed << setprecision( 1 ) << megabytes_per_second
+               << " MB/s, " << sender_stats.retransmissions << " retransmissions, " << setprecision( 2 )
+               << cpu_ns_per_byte << " CPU ns/byte\n";
+}
+
+} // namespace
+
+void program_body()
+{
+  speed_test( "clean", 64 << 20, {} );
+  speed_test( "1% loss, 1% reordering, 1 ms delay", 4 << 20, { 0.01, 0.01, 1 } );
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,102 @@
+#include "socket.hh"
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+void expect( bool condition, const string& what )
+{
+  if ( not condition ) {
+    throw runtime_error( "UDPSocket: expected " + what );
+  }
+}
+
+struct Endpoints
+{
+  UDPSocket tx {};
+  UDPSocket rx {};
+
+  Endpoints()
+  {
+    tx.bind( Address { "127.0.0.1" } );
+    rx.bind( Address { "127.0.0.1" } );
+    rx.set_blocking( false );
+  }
+};
+
+// A datagram too large for its slot is dropped and counted, and the rest of the batch still comes through
+void oversized()
+{
+  Endpoints endpoints;
+  DatagramBatch batch { 8, 100 };
+
+  endpoints.tx.sendto( endpoints.rx.local_address(), string( 10, 'a' ) );
+  endpoints.tx.sendto( endpoints.rx.local_address(), string( 200, 'b' ) );
+  endpoints.tx.sendto( endpoints.rx.local_address(), string( 20, 'c' ) );
+  endpoints.tx.sendto( endpoints.rx.local_address(), string( 100, 'd' ) );
+
+  expect( endpoints.rx.recv_batch( batch ) == 3, "the datagrams that fit" );
+  expect( batch.truncated() == 1, "the oversized datagram to be counted" );
+  expect( string_view { batch.payload( 0 ) } == string( 10, 'a' )
+            and string_view { batch.payload( 1 ) } == string( 20, 'c' )
+            and string_view { batch.payload( 2 ) } == string( 100, 'd' ),
+          "the datagrams that fit, in order" );
+  for ( size_t i = 0; i < batch.size(); i++ ) {
+    expect( batch.address( i ) == endpoints.tx.local_address(), "each datagram's source" );
+    expect( batch.segment_size( i ) == batch.payload( i ).size(), "each datagram's own size" );
+  }
+
+  // A batch of nothing but oversized datagrams is dropped whole, and whatever follows taken in its place
+  endpoints.tx.sendto( endpoints.rx.local_address(), string( 101, 'e' ) );
+  expect( endpoints.rx.recv_batch( batch ) == 0 and batch.truncated() == 1, "nothing but a dropped datagram" );
+  expect( endpoints.rx.recv_batch( batch ) == 0 and batch.truncated() == 0, "nothing left" );
+
+  DatagramBatch one { 1, 100 };
+  endpoints.tx.sendto( endpoints.rx.local_address(), string( 300, 'f' ) );
+  endpoints.tx.sendto( endpoints.rx.local_address(), "g" );
+  expect( endpoints.rx.recv_batch( one ) == 1 and one.truncated() == 1, "the next datagram after a dropped one" );
+  expect( string_view { one.payload( 0 ) } == "g", "the datagram after the dropped one" );
+}
+
+// Runs of equal-size segments, each cut short by a smaller one, all arrive as datagrams of their own
+void segments()
+{
+  Endpoints endpoints;
+  vector<Buffer> to_send;
+  for ( const size_t size : { 100, 100, 100, 40, 100, 100, 0, 7 } ) {
+    to_send.emplace_back( string( size, static_cast<char>( 'a' + to_send.size() ) ) );
+  }
+  expect( endpoints.tx.send_segments( endpoints.rx.local_address(), to_send ) == to_send.size(),
+          "every segment to be sent" );
+
+  DatagramBatch batch { 16, 100 };
+  size_t received = 0;
+  while ( received < to_send.size() and endpoints.rx.recv_batch( batch ) > 0 ) {
+    for ( size_t i = 0; i < batch.size(); i++, received++ ) {
+      expect( string_view { batch.payload( i ) } == string_view { to_send[received] },
+              "segment " + to_string( received ) + " as its own datagram" );
+    }
+  }
+  expect( received == to_send.size(), "every segment to arrive" );
+}
+
+} // namespace
+
+int main()
+{
+  try {
+    oversized();
+    segments();
+  } catch ( const exception& e ) {
+    cerr << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
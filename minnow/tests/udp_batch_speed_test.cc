@@ -0,0 +1,116 @@
+#include "socket.hh"
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+
+constexpr size_t datagram_size = 256;
+constexpr size_t n_datagrams = 1 << 18;
+
+struct Endpoints
+{
+  UDPSocket tx {};
+  UDPSocket rx {};
+  Address destination { "0" };
+
+  Endpoints()
+  {
+    rx.bind( Address { "127.0.0.1" } );
+    destination = rx.local_address();
+  }
+};
+
+double datagrams_per_second( steady_clock::duration elapsed )
+{
+  return static_cast<double>( n_datagrams ) / duration_cast<duration<double>>( elapsed ).count();
+}
+
+// One sendto() and one recv() per datagram
+double unbatched_rate( const string& payload )
+{
+  Endpoints endpoints;
+  Address source { "0" };
+  array<char, Buffer::POOLED_CAPACITY> received {};
+
+  const auto start_time = steady_clock::now();
+  for ( size_t i = 0; i < n_datagrams; i++ ) {
+    endpoints.tx.sendto( endpoints.destination, payload );
+    if ( endpoints.rx.recv( source, received ) != payload.size() ) {
+      throw runtime_error( "datagram arrived truncated" );
+    }
+  }
+  return datagrams_per_second( steady_clock::now() - start_time );
+}
+
+// Datagrams sent with send_batch() and received with recv_batch(), `batch_size` per call
+double batched_rate( const string& payload, size_t batch_size )
+{
+  Endpoints endpoints;
+  DatagramBatch outgoing { batch_size };
+  DatagramBatch incoming { batch_size };
+  const Buffer bytes { payload };
+  for ( size_t i = 0; i < batch_size; i++ ) {
+    outgoing.push_back( endpoints.destination, bytes );
+  }
+
+  const auto start_time = steady_clock::now();
+  for ( size_t sent = 0; sent < n_datagrams; sent += batch_size ) {
+    endpoints.tx.send_batch( outgoing );
+    for ( size_t received = 0; received < batch_size; ) {
+      received += endpoints.rx.recv_batch( incoming );
+      if ( incoming.payload( incoming.size() - 1 ).size() != payload.size() ) {
+        throw runtime_error( "datagram arrived truncated" );
+      }
+    }
+  }
+  const auto elapsed = steady_clock::now() - start_time;
+
+  if ( string_view { incoming.payload( 0 ) } != payload ) {
+    throw runtime_error( "datagram arrived garbled" );
+  }
+  return datagrams_per_second( elapsed );
+}
+
+} // namespace
+
+void program_body()
+{
+  const string payload( datagram_size, 'x' );
+
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  const double unbatched = unbatched_rate( payload );
+  cout << "Loopback UDP, " << datagram_size << "-byte datagrams: " << fixed << setprecision( 0 ) << unbatched
+       << " datagrams/s with sendto/recvfrom.\n";
+  debug_output << "      UDP sendto/recvfrom: " << fixed << setprecision( 0 ) << unbatched << " datagrams/s\n";
+
+  for ( size_t batch_size = 1; batch_size <= 64; batch_size *= 2 ) {
+    const double batched = batched_rate( payload, batch_size );
+    cout << "Loopback UDP, " << datagram_size << "-byte datagrams: " << fixed << setprecision( 0 ) << batched
+         << " datagrams/s with sendmmsg/recvmmsg in batches of " << batch_size << ".\n";
+    debug_output << "      UDP sendmmsg/recvmmsg (batch " << batch_size << "): " << fixed << setprecision( 0 )
+                 << batched << " datagrams/s\n";
+  }
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,107 @@
+#include "socket.hh"
+#include "tcp_config.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+namespace {
+
+constexpr size_t segment_size = TCPConfig::MAX_PAYLOAD_SIZE;
+constexpr size_t window = 32; // segments in flight at once
+constexpr size_t n_segments = 1 << 17;
+
+enum class Offload
+{
+  None,
+  Send,
+  SendAndReceive
+};
+
+// Send windows of equal-size segments over loopback and read them back; returns bytes per second
+double throughput( Offload offload )
+{
+  UDPSocket tx;
+  UDPSocket rx;
+  rx.bind( Address { "127.0.0.1" } );
+  const Address destination = rx.local_address();
+
+  const Buffer segment { string( segment_size, 'x' ) };
+  const vector<Buffer> segments( window, segment );
+  DatagramBatch outgoing { window };
+  for ( const auto& each : segments ) {
+    outgoing.push_back( destination, each );
+  }
+
+  // With GRO a window can arrive as a few coalesced payloads, each up to the GSO maximum
+  if ( offload == Offload::SendAndReceive ) {
+    rx.set_gro( true );
+  }
+  DatagramBatch incoming = offload == Offload::SendAndReceive ? DatagramBatch { 4, UDPSocket::MAX_GSO_SIZE }
+                                                               : DatagramBatch { window };
+
+  size_t coalesced_segment_size = segment_size;
+  const auto start_time = steady_clock::now();
+  for ( size_t sent = 0; sent < n_segments; sent += window ) {
+    if ( offload == Offload::None ) {
+      tx.send_batch( outgoing );
+    } else {
+      tx.send_segments( destination, segments );
+    }
+
+    for ( size_t received = 0; received < window * segment_size; ) {
+      rx.recv_batch( incoming );
+      for ( size_t i = 0; i < incoming.size(); i++ ) {
+        received += incoming.payload( i ).size();
+        coalesced_segment_size = min( coalesced_segment_size, incoming.segment_size( i ) );
+      }
+    }
+  }
+  const auto elapsed = steady_clock::now() - start_time;
+
+  if ( coalesced_segment_size != segment_size ) {
+    throw runtime_error( "datagrams were coalesced at the wrong boundaries" );
+  }
+  return static_cast<double>( n_segments * segment_size ) / duration_cast<duration<double>>( elapsed ).count();
+}
+
+void report( const string& name, double bytes_per_second )
+{
+  fstream debug_output;
+  debug_output.open( "/dev/tty" );
+
+  const double megabytes = bytes_per_second / 1e6;
+  const double datagrams = bytes_per_second / segment_size;
+
+  cout << "Loopback UDP, " << segment_size << "-byte segments in windows of " << window << ", " << name << ": "
+       << fixed << setprecision( 0 ) << megabytes << " MB/s (" << datagrams << " datagrams/s).\n";
+  debug_output << "      UDP " << name << ": " << fixed << setprecision( 0 ) << megabytes << " MB/s\n";
+}
+
+} // namespace
+
+void program_body()
+{
+  report( "sendmmsg/recvmmsg", throughput( Offload::None ) );
+  report( "GSO send", throughput( Offload::Send ) );
+  report( "GSO send + GRO receive", throughput( Offload::SendAndReceive ) );
+}
+
+int main()
+{
+  try {
+    program_body();
+  } catch ( const exception& e ) {
+    cerr << "Exception: " << e.what() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
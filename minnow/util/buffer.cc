@@ -0,0 +1,144 @@
+#include "buffer.hh"
+
+#include <cstring>
+#include <new>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+// Strings up to this long are copied into a pooled chunk rather than adopted: the copy is cheaper than
+// allocating a chunk to hold the string
+constexpr size_t COPY_THRESHOLD = 512;
+
+// Set once this thread's pool has been destroyed; chunks released after that go straight to the heap
+thread_local bool pool_destroyed = false;
+
+// Free chunks of the pooled size, kept for reuse by this thread
+class ChunkPool
+{
+  vector<void*> free_ {};
+
+public:
+  static constexpr size_t MAX_FREE = 4096; // beyond this many, freed chunks go back to the heap
+
+  ChunkPool() = default;
+  ChunkPool( const ChunkPool& other ) = delete;
+  ChunkPool& operator=( const ChunkPool& other ) = delete;
+
+  ~ChunkPool()
+  {
+    for ( void* chunk : free_ ) {
+      ::operator delete( chunk );
+    }
+    pool_destroyed = true;
+  }
+
+  void* get( size_t bytes )
+  {
+    if ( free_.empty() ) {
+      return ::operator new( bytes );
+    }
+    void* chunk = free_.back();
+    free_.pop_back();
+    return chunk;
+  }
+
+  void put( void* chunk )
+  {
+    if ( free_.size() >= MAX_FREE ) {
+      ::operator delete( chunk );
+      return;
+    }
+    free_.push_back( chunk );
+  }
+};
+
+thread_local ChunkPool pool;
+
+} // namespace
+
+Buffer::Chunk* Buffer::allocate( size_t capacity )
+{
+  void* memory {};
+  if ( capacity <= POOLED_CAPACITY ) {
+    capacity = POOLED_CAPACITY;
+    memory = pool_destroyed ? ::operator new( sizeof( Chunk ) + capacity ) : pool.get( sizeof( Chunk ) + capacity );
+  } else {
+    memory = ::operator new( sizeof( Chunk ) + capacity );
+  }
+  return new ( memory ) Chunk { 1, static_cast<uint32_t>( capacity ), {} };
+}
+
+Buffer::Chunk* Buffer::adopt( string&& str )
+{
+  void* memory = ::operator new( sizeof( Chunk ) );
+  return new ( memory ) Chunk { 1, 0, move( str ) };
+}
+
+void Buffer::release( Chunk* chunk )
+{
+  const bool pooled = chunk->capacity == POOLED_CAPACITY;
+  chunk->~Chunk();
+  if ( pooled and not pool_destroyed ) {
+    pool.put( chunk );
+  } else {
+    ::operator delete( chunk );
+  }
+}
+
+Buffer::Buffer( string str ) : chunk_(), offset_( 0 ), length_( static_cast<uint32_t>( str.size() ) )
+{
+  if ( str.empty() ) {
+    return;
+  }
+  if ( str.size() <= COPY_THRESHOLD ) {
+    chunk_ = allocate( str.size() );
+    memcpy( chunk_->storage(), str.data(), str.size() );
+  } else {
+    chunk_ = adopt( move( str ) );
+  }
+}
+
+Buffer Buffer::copy_of( string_view bytes )
+{
+  Buffer ret = uninitialized( bytes.size() );
+  if ( not bytes.empty() ) {
+    memcpy( ret.mutable_data(), bytes.data(), bytes.size() );
+  }
+  return ret;
+}
+
+Buffer Buffer::uninitialized( size_t length, size_t headroom )
+{
+  Buffer ret;
+  if ( length + headroom == 0 ) {
+    return ret;
+  }
+  ret.chunk_ = allocate( length + headroom );
+  ret.offset_ = static_cast<uint32_t>( headroom );
+  ret.length_ = static_cast<uint32_t>( length );
+  return ret;
+}
+
+bool Buffer::prepend( string_view bytes )
+{
+  if ( bytes.size() > offset_ or not unique() ) {
+    return false;
+  }
+  offset_ -= static_cast<uint32_t>( bytes.size() );
+  length_ += static_cast<uint32_t>( bytes.size() );
+  memcpy( mutable_data(), bytes.data(), bytes.size() );
+  return true;
+}
+
+string Buffer::release()
+{
+  if ( unique() and chunk_->capacity == 0 and offset_ == 0 and length_ == chunk_->owned.size() ) {
+    string ret = move( chunk_->owned );
+    *this = Buffer {};
+    return ret;
+  }
+  return *this;
+}
@@ -1,23 +1,124 @@
 #pragma once
 
-#include <memory>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <utility>
 
+// A reference-counted, immutable view of bytes, cheap to copy and to slice.
+//
+// Small buffers (headers, MTU-sized payloads) live in fixed-size chunks recycled through a per-thread
+// pool, so making one usually costs no heap allocation. Larger strings are adopted without copying.
+// The reference count is not atomic: a Buffer and its copies must be used from one thread at a time.
 class Buffer
 {
-  std::shared_ptr<std::string> buffer_;
+  struct Chunk
+  {
+    uint32_t refs;
+    uint32_t capacity;  // bytes of storage following the Chunk (0 if the bytes live in `owned`)
+    std::string owned;  // adopted string, for chunks not from the pool
+    char* storage() { return capacity ? reinterpret_cast<char*>( this + 1 ) : owned.data(); } // NOLINT
+  };
+
+  Chunk* chunk_ {};
+  uint32_t offset_ {};
+  uint32_t length_ {};
+
+  static Chunk* allocate( size_t capacity );
+  static Chunk* adopt( std::string&& str );
+  static void release( Chunk* chunk );
+
+  void drop()
+  {
+    if ( chunk_ and --chunk_->refs == 0 ) {
+      release( chunk_ );
+    }
+  }
 
 public:
+  static constexpr size_t POOLED_CAPACITY = 2048 - 64; // largest buffer that comes from the pool
+  static constexpr size_t HEADROOM = 64;               // enough room in front of a payload for its headers
+
   // NOLINTBEGIN(*-explicit-*)
 
-  Buffer( std::string str = {} ) : buffer_( make_shared<std::string>( std::move( str ) ) ) {}
-  operator std::string_view() const { return *buffer_; }
-  operator std::string&() { return *buffer_; }
+  Buffer() = default;
+  Buffer( std::string str );
+  operator std::string_view() const { return { data(), length_ }; }
+  operator std::string() const { return std::string { data(), length_ }; }
 
   // NOLINTEND(*-explicit-*)
 
-  std::string&& release() { return std::move( *buffer_ ); }
-  size_t size() const { return buffer_->size(); }
-  size_t length() const { return buffer_->length(); }
-  bool empty() const { return buffer_->empty(); }
+  // A Buffer holding a copy of `bytes`
+  static Buffer copy_of( std::string_view bytes );
+
+  // A Buffer of `length` unspecified bytes, to be filled in through mutable_data(), with `headroom`
+  // bytes free in front of it for prepend(). Headroom is only of use to a Buffer that will still be
+  // unique when its headers are written (see Serializer::buffer), not to one that is kept and shared.
+  static Buffer uninitialized( size_t length, size_t headroom = 0 );
+
+  Buffer( const Buffer& other ) : chunk_( other.chunk_ ), offset_( other.offset_ ), length_( other.length_ )
+  {
+    if ( chunk_ ) {
+      chunk_->refs++;
+    }
+  }
+
+  Buffer( Buffer&& other ) noexcept
+    : chunk_( std::exchange( other.chunk_, nullptr ) )
+    , offset_( std::exchange( other.offset_, 0 ) )
+    , length_( std::exchange( other.length_, 0 ) )
+  {}
+
+  Buffer& operator=( const Buffer& other )
+  {
+    Buffer copy { other };
+    swap( copy );
+    return *this;
+  }
+
+  Buffer& operator=( Buffer&& other ) noexcept
+  {
+    Buffer moved { std::move( other ) };
+    swap( moved );
+    return *this;
+  }
+
+  ~Buffer() { drop(); }
+
+  void swap( Buffer& other ) noexcept
+  {
+    std::swap( chunk_, other.chunk_ );
+    std::swap( offset_, other.offset_ );
+    std::swap( length_, other.length_ );
+  }
+
+  const char* data() const { return chunk_ ? chunk_->storage() + offset_ : ""; }
+  size_t size() const { return length_; }
+  size_t length() const { return length_; }
+  bool empty() const { return length_ == 0; }
+
+  // Whether no other Buffer shares these bytes (so they may be written)
+  bool unique() const { return chunk_ and chunk_->refs == 1; }
+
+  // Writable bytes; only for a unique() Buffer, e.g. one just made by uninitialized()
+  char* mutable_data() { return chunk_ ? chunk_->storage() + offset_ : nullptr; }
+
+  // The bytes [offset, offset + len) of this Buffer, sharing its storage
+  Buffer slice( size_t offset, size_t len = std::string::npos ) const
+  {
+    Buffer ret { *this };
+    offset = std::min( offset, size_t { length_ } );
+    ret.offset_ += static_cast<uint32_t>( offset );
+    ret.length_ = static_cast<uint32_t>( std::min( len, length_ - offset ) );
+    return ret;
+  }
+
+  // Write `bytes` into the headroom in front of this Buffer and extend it to cover them. Returns false
+  // (and changes nothing) if the Buffer is shared or there is not enough headroom.
+  bool prepend( std::string_view bytes );
+
+  // The contents as a std::string (moved out, when the Buffer adopted a string and is its only user)
+  std::string release();
 };
@@ -0,0 +1,48 @@
+#include "buffer_chain.hh"
+
+using namespace std;
+
+void BufferChain::truncate( size_t length )
+{
+  Buffer* buffers = spilled() ? spilled_buffers_.data() : inline_buffers_.data();
+  iovec* iovecs = spilled() ? spilled_iovecs_.data() : inline_iovecs_.data();
+
+  size_t kept = 0;
+  while ( kept < size() and length > 0 ) {
+    if ( buffers[kept].size() > length ) {
+      buffers[kept] = buffers[kept].slice( 0, length );
+      iovecs[kept] = iovec_of( buffers[kept] );
+    }
+    length -= buffers[kept].size();
+    kept++;
+  }
+
+  if ( spilled() ) {
+    spilled_buffers_.resize( kept );
+    spilled_iovecs_.resize( kept );
+    return;
+  }
+  for ( size_t i = kept; i < inline_size_; i++ ) {
+    inline_buffers_[i] = Buffer {};
+  }
+  inline_size_ = kept;
+}
+
+size_t BufferChain::length() const
+{
+  size_t total = 0;
+  for ( const auto& buffer : *this ) {
+    total += buffer.size();
+  }
+  return total;
+}
+
+string BufferChain::concatenate() const
+{
+  string ret;
+  ret.reserve( length() );
+  for ( const auto& buffer : *this ) {
+    ret.append( buffer );
+  }
+  return ret;
+}
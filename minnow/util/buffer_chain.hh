@@ -0,0 +1,156 @@
+#pragma once
+
+#include "buffer.hh"
+
+#include <array>
+#include <cstddef>
+#include <initializer_list>
+#include <span>
+#include <string>
+#include <sys/uio.h>
+#include <utility>
+#include <vector>
+
+// A sequence of Buffers that together make up one message (e.g. a frame's headers and its payload).
+//
+// The first few Buffers are stored in the object itself, so a typical frame costs no allocation. Alongside
+// the Buffers the chain keeps a matching array of iovecs, which can be handed straight to writev/sendmsg
+// (or, for a chain of unique Buffers, to readv/recvmsg) without flattening the bytes or building the array
+// per call. To keep the two in step, the Buffers can only be changed through the chain's own methods.
+class BufferChain
+{
+public:
+  static constexpr size_t INLINE_CAPACITY = 4;
+
+private:
+  std::array<Buffer, INLINE_CAPACITY> inline_buffers_ {};
+  std::array<iovec, INLINE_CAPACITY> inline_iovecs_ {};
+  size_t inline_size_ {};
+
+  // Every Buffer, once there have been more than fit inline
+  std::vector<Buffer> spilled_buffers_ {};
+  std::vector<iovec> spilled_iovecs_ {};
+
+  bool spilled() const { return not spilled_buffers_.empty(); }
+
+  static iovec iovec_of( const Buffer& buffer )
+  {
+    return { const_cast<char*>( buffer.data() ), buffer.size() }; // NOLINT(*-const-cast)
+  }
+
+  void spill()
+  {
+    spilled_buffers_.reserve( 2 * INLINE_CAPACITY );
+    spilled_iovecs_.reserve( 2 * INLINE_CAPACITY );
+    for ( size_t i = 0; i < inline_size_; i++ ) {
+      spilled_buffers_.push_back( std::move( inline_buffers_[i] ) );
+      spilled_iovecs_.push_back( inline_iovecs_[i] );
+    }
+    inline_size_ = 0;
+  }
+
+public:
+  BufferChain() = default;
+
+  // NOLINTNEXTLINE(*-explicit-*)
+  BufferChain( std::initializer_list<Buffer> buffers )
+  {
+    for ( const auto& buffer : buffers ) {
+      push_back( buffer );
+    }
+  }
+
+  BufferChain( const BufferChain& other ) = default;
+  BufferChain& operator=( const BufferChain& other ) = default;
+
+  BufferChain( BufferChain&& other ) noexcept
+    : inline_buffers_( std::move( other.inline_buffers_ ) )
+    , inline_iovecs_( other.inline_iovecs_ )
+    , inline_size_( std::exchange( other.inline_size_, 0 ) )
+    , spilled_buffers_( std::move( other.spilled_buffers_ ) )
+    , spilled_iovecs_( std::move( other.spilled_iovecs_ ) )
+  {
+    other.clear();
+  }
+
+  BufferChain& operator=( BufferChain&& other ) noexcept
+  {
+    inline_buffers_ = std::move( other.inline_buffers_ );
+    inline_iovecs_ = other.inline_iovecs_;
+    inline_size_ = std::exchange( other.inline_size_, 0 );
+    spilled_buffers_ = std::move( other.spilled_buffers_ );
+    spilled_iovecs_ = std::move( other.spilled_iovecs_ );
+    other.clear();
+    return *this;
+  }
+
+  ~BufferChain() = default;
+
+  void push_back( Buffer buffer )
+  {
+    if ( not spilled() and inline_size_ < INLINE_CAPACITY ) {
+      inline_iovecs_[inline_size_] = iovec_of( buffer );
+      inline_buffers_[inline_size_++] = std::move( buffer );
+      return;
+    }
+    if ( not spilled() ) {
+      spill();
+    }
+    spilled_iovecs_.push_back( iovec_of( buffer ) );
+    spilled_buffers_.push_back( std::move( buffer ) );
+  }
+
+  template<typename... Args>
+  const Buffer& emplace_back( Args&&... args )
+  {
+    push_back( Buffer( std::forward<Args>( args )... ) );
+    return back();
+  }
+
+  // Make room for `n` Buffers (only matters beyond the inline capacity)
+  void reserve( size_t n )
+  {
+    if ( n > INLINE_CAPACITY ) {
+      spilled_buffers_.reserve( n );
+      spilled_iovecs_.reserve( n );
+    }
+  }
+
+  void clear()
+  {
+    for ( size_t i = 0; i < inline_size_; i++ ) {
+      inline_buffers_[i] = Buffer {};
+    }
+    inline_size_ = 0;
+    spilled_buffers_.clear();
+    spilled_iovecs_.clear();
+  }
+
+  // Keep only the first `length` bytes of the chain (e.g. the part that a readv filled in)
+  void truncate( size_t length );
+
+  const Buffer* begin() const { return spilled() ? spilled_buffers_.data() : inline_buffers_.data(); }
+  const Buffer* end() const { return begin() + size(); }
+  const Buffer* data() const { return begin(); }
+  size_t size() const { return spilled() ? spilled_buffers_.size() : inline_size_; }
+  bool empty() const { return size() == 0; }
+
+  const Buffer& operator[]( size_t i ) const { return begin()[i]; }
+  const Buffer& front() const { return *begin(); }
+  const Buffer& back() const { return end()[-1]; }
+
+  // Total bytes in the chain
+  size_t length() const;
+
+  // The chain as an iovec array, in step with the Buffers
+  std::span<const iovec> iovecs() const
+  {
+    if ( spilled() ) {
+      return spilled_iovecs_;
+    }
+    return { inline_iovecs_.data(), inline_size_ };
+  }
+
+  // The bytes of the chain in one string (a copy; for callers that really need them contiguous)
+  std::string concatenate() const;
+};
@@ -0,0 +1,152 @@
+#include "checksum.hh"
+
+#include <bit>
+#include <cstring>
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#include <immintrin.h>
+#define CHECKSUM_HAVE_AVX2 1
+#endif
+
+using namespace std;
+
+namespace {
+
+// Add with end-around carry, so the 64-bit accumulator stays a one's-complement sum
+uint64_t add_carry( uint64_t sum, uint64_t x )
+{
+  sum += x;
+  return sum + ( sum < x );
+}
+
+// Fold a one's-complement sum of native-order words to 16 bits, then put it in network byte order
+// (the one's-complement sum is byte-order independent, RFC 1071 section 2)
+uint16_t fold( uint64_t sum )
+{
+  sum = ( sum >> 32 ) + ( sum & 0xffffffff );
+  sum = ( sum >> 32 ) + ( sum & 0xffffffff );
+  sum = ( sum >> 16 ) + ( sum & 0xffff );
+  sum = ( sum >> 16 ) + ( sum & 0xffff );
+  const auto folded = static_cast<uint16_t>( sum );
+  if constexpr ( endian::native == endian::little ) {
+    return static_cast<uint16_t>( ( folded >> 8 ) | ( folded << 8 ) );
+  }
+  return folded;
+}
+
+// Sum the last < 8 bytes, zero-padded on the right like a short final word
+uint64_t sum_tail( const char* data, size_t len )
+{
+  // `data` may be null when there is nothing left (e.g. an empty string_view), and memcpy must not see that
+  if ( len == 0 ) {
+    return 0;
+  }
+  uint64_t word = 0;
+  memcpy( &word, data, len );
+  return word;
+}
+
+// The kernels below sum `len` bytes of `data` and, when `Copy` is set, also copy them to `dst` on
+// the way through, so a payload that is being copied anyway is summed without a second pass
+
+template<bool Copy>
+uint64_t sum_scalar( char* dst, const char* data, size_t len )
+{
+  // Four independent accumulators keep the carries of successive words from serializing
+  uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+  for ( ; len >= 32; data += 32, dst += Copy ? 32 : 0, len -= 32 ) {
+    uint64_t w[4];
+    memcpy( w, data, sizeof( w ) );
+    if constexpr ( Copy ) {
+      memcpy( dst, w, sizeof( w ) );
+    }
+    s0 = add_carry( s0, w[0] );
+    s1 = add_carry( s1, w[1] );
+    s2 = add_carry( s2, w[2] );
+    s3 = add_carry( s3, w[3] );
+  }
+  for ( ; len >= 8; data += 8, dst += Copy ? 8 : 0, len -= 8 ) {
+    uint64_t w = 0;
+    memcpy( &w, data, sizeof( w ) );
+    if constexpr ( Copy ) {
+      memcpy( dst, &w, sizeof( w ) );
+    }
+    s0 = add_carry( s0, w );
+  }
+  if constexpr ( Copy ) {
+    if ( len > 0 ) {
+      memcpy( dst, data, len );
+    }
+  }
+  return add_carry( add_carry( s0, s1 ), add_carry( add_carry( s2, s3 ), sum_tail( data, len ) ) );
+}
+
+#if defined( CHECKSUM_HAVE_AVX2 )
+// Widen each 32-bit word of a 32-byte block into a 64-bit lane; the lanes cannot overflow before
+// 2^32 blocks (128 GiB), far beyond anything one call is given
+template<bool Copy>
+__attribute__( ( target( "avx2" ) ) ) uint64_t sum_avx2( char* dst, const char* data, size_t len )
+{
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i acc0 = zero;
+  __m256i acc1 = zero;
+  for ( ; len >= 64; data += 64, dst += Copy ? 64 : 0, len -= 64 ) {
+    const auto* block = reinterpret_cast<const __m256i*>( data ); // NOLINT(*-reinterpret-cast)
+    const __m256i a = _mm256_loadu_si256( block );
+    const __m256i b = _mm256_loadu_si256( block + 1 );
+    if constexpr ( Copy ) {
+      auto* out = reinterpret_cast<__m256i*>( dst ); // NOLINT(*-reinterpret-cast)
+      _mm256_storeu_si256( out, a );
+      _mm256_storeu_si256( out + 1, b );
+    }
+    acc0 = _mm256_add_epi64( acc0, _mm256_unpacklo_epi32( a, zero ) );
+    acc1 = _mm256_add_epi64( acc1, _mm256_unpackhi_epi32( a, zero ) );
+    acc0 = _mm256_add_epi64( acc0, _mm256_unpacklo_epi32( b, zero ) );
+    acc1 = _mm256_add_epi64( acc1, _mm256_unpackhi_epi32( b, zero ) );
+  }
+
+  uint64_t lanes[8];
+  _mm256_storeu_si256( reinterpret_cast<__m256i*>( lanes ), acc0 );     // NOLINT(*-reinterpret-cast)
+  _mm256_storeu_si256( reinterpret_cast<__m256i*>( lanes + 4 ), acc1 ); // NOLINT(*-reinterpret-cast)
+  uint64_t sum = sum_scalar<Copy>( dst, data, len );
+  for ( const uint64_t lane : lanes ) {
+    sum = add_carry( sum, lane );
+  }
+  return sum;
+}
+#endif
+
+using SumKernel = uint64_t ( * )( char*, const char*, size_t );
+
+// Short inputs (headers, mostly) are not worth the vector setup
+constexpr size_t VECTOR_THRESHOLD = 128;
+
+template<bool Copy>
+uint64_t sum( char* dst, string_view data )
+{
+  static const SumKernel kernel = [] {
+#if defined( CHECKSUM_HAVE_AVX2 )
+    if ( __builtin_cpu_supports( "avx2" ) ) {
+      return SumKernel { sum_avx2<Copy> };
+    }
+#endif
+    return SumKernel { sum_scalar<Copy> };
+  }();
+
+  if ( data.size() < VECTOR_THRESHOLD ) {
+    return sum_scalar<Copy>( dst, data.data(), data.size() );
+  }
+  return kernel( dst, data.data(), data.size() );
+}
+
+} // namespace
+
+uint16_t internet_checksum_sum( string_view data )
+{
+  return fold( sum<false>( nullptr, data ) );
+}
+
+uint16_t copy_and_checksum( char* dst, string_view src )
+{
+  return fold( sum<true>( dst, src ) );
+}
@@ -3,42 +3,76 @@
 #include "buffer.hh"
 
 #include <cstdint>
+#include <span>
 #include <string>
-#include <vector>
+
+// One's-complement sum of `data` taken as big-endian 16-bit words (a trailing odd byte is padded with
+// zero), folded to 16 bits. Runs the widest kernel the CPU supports, chosen once at startup.
+uint16_t internet_checksum_sum( std::string_view data );
+
+// Copy `src` to `dst` (which must have room for src.size() bytes) and return the same sum as
+// internet_checksum_sum( src ), reading each byte only once
+uint16_t copy_and_checksum( char* dst, std::string_view src );
 
 //! The internet checksum algorithm
 class InternetChecksum
 {
 private:
-  uint32_t sum_;
-  bool parity_ {};
+  uint64_t sum_;
+  bool parity_ {}; // an odd number of bytes has been added so far
 
 public:
   explicit InternetChecksum( const uint32_t sum = 0 ) : sum_( sum ) {}
   void add( std::string_view data )
   {
-    for ( const uint8_t i : data ) {
-      uint16_t val = i;
-      if ( not parity_ ) {
-        val <<= 8;
-      }
-      sum_ += val;
-      parity_ = !parity_;
+    if ( data.empty() ) {
+      return;
+    }
+
+    // Finish the word left half-done by an odd-length fragment, so the rest starts word-aligned
+    if ( parity_ ) {
+      sum_ += static_cast<uint8_t>( data.front() );
+      data.remove_prefix( 1 );
+      parity_ = false;
     }
+
+    sum_ += internet_checksum_sum( data );
+    parity_ = data.size() % 2;
   }
 
-  uint16_t value() const
+  // Like add( data ), but also copies `data` to `dst` in the same pass
+  void add_copy( char* dst, std::string_view data )
   {
-    uint32_t ret = sum_;
+    if ( data.empty() ) {
+      return;
+    }
+
+    if ( parity_ ) {
+      *dst++ = data.front();
+      sum_ += static_cast<uint8_t>( data.front() );
+      data.remove_prefix( 1 );
+      parity_ = false;
+    }
+
+    sum_ += copy_and_checksum( dst, data );
+    parity_ = data.size() % 2;
+  }
+
+  // The one's-complement sum so far, before the final complement (e.g. to seed another checksum)
+  uint16_t sum() const
+  {
+    uint64_t ret = sum_;
 
     while ( ret > 0xffff ) {
       ret = ( ret >> 16 ) + static_cast<uint16_t>( ret );
     }
 
-    return ~ret;
+    return ret;
   }
 
-  void add( const std::vector<Buffer>& data )
+  uint16_t value() const { return ~sum(); }
+
+  void add( std::span<const Buffer> data )
   {
     for ( const auto& x : data ) {
       add( x );
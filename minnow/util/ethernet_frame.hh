@@ -1,15 +1,13 @@
 #pragma once
 
-#include "buffer.hh"
+#include "buffer_chain.hh"
 #include "ethernet_header.hh"
 #include "parser.hh"
 
-#include <vector>
-
 struct EthernetFrame
 {
   EthernetHeader header {};
-  std::vector<Buffer> payload {};
+  BufferChain payload {};
 
   void parse( Parser& parser )
   {
@@ -0,0 +1,271 @@
+#include "eventloop.hh"
+
+#include "exception.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <stdexcept>
+#include <utility>
+
+using namespace std;
+
+EventLoop::EventLoop() : epoll_( CheckSystemCall( "epoll_create1", ::epoll_create1( EPOLL_CLOEXEC ) ) ) {}
+
+void EventLoop::RuleHandle::cancel()
+{
+  if ( const shared_ptr<Rule> rule = rule_.lock() ) {
+    EventLoop::cancel_rule( *rule );
+  }
+}
+
+void EventLoop::RuleHandle::wake()
+{
+  if ( const shared_ptr<Rule> rule = rule_.lock(); rule and rule->wake ) {
+    rule->wake();
+  }
+}
+
+// The caller must hold a reference to the rule, since detaching it may drop the loop's own
+void EventLoop::cancel_rule( Rule& rule )
+{
+  if ( rule.cancelled ) {
+    return;
+  }
+  rule.cancelled = true;
+  rule.detach();
+  if ( rule.on_cancel ) {
+    rule.on_cancel();
+  }
+}
+
+EventLoop::RuleHandle EventLoop::add_rule( const FileDescriptor& fd,
+                                           const Direction direction,
+                                           const CallbackT& callback,
+                                           const InterestT& interest,
+                                           const CallbackT& cancel,
+                                           const Trigger trigger )
+{
+  const bool parked = interest and not interest(); // asked before `reg` is taken, in case it adds rules
+  const int fd_num = fd.fd_num();
+
+  // The number may belong to a descriptor that was closed while it still had rules
+  if ( const Registration* existing = registrations_.find( fd_num ) ) {
+    cancel_if_closed( *existing );
+  }
+  auto [reg, inserted] = registrations_.try_emplace( fd_num );
+  if ( inserted ) {
+    reg->generation = ++next_generation_;
+  }
+
+  shared_ptr<FDRule>& slot = direction == Direction::In ? reg->in : reg->out;
+  const shared_ptr<FDRule>& other = direction == Direction::In ? reg->out : reg->in;
+  if ( slot ) {
+    throw runtime_error( "EventLoop: descriptor already has a rule for this direction" );
+  }
+  if ( other and other->trigger != trigger ) {
+    throw runtime_error( "EventLoop: level- and edge-triggered rules on the same descriptor" );
+  }
+
+  slot = make_shared<FDRule>( fd.duplicate(), direction, trigger, interest );
+  slot->callback = callback;
+  slot->on_cancel = cancel;
+  slot->detach = [this, fd_num, direction] { remove( fd_num, direction ); };
+  slot->wake = [this, rule = slot.get()] { unpark( *rule ); }; // called with the rule held by its handle
+  slot->closed = [this, rule = weak_ptr<FDRule> { slot }] { closed_.push_back( rule ); };
+  slot->fd.watch_close( { slot, &slot->closed } ); // lives (and so is called back) only as long as the rule
+  slot->parked = parked;
+
+  RuleHandle handle { slot };
+  update( fd_num );
+  return handle;
+}
+
+EventLoop::RuleHandle EventLoop::add_timer( const chrono::milliseconds delay,
+                                            const CallbackT& callback,
+                                            const bool repeat )
+{
+  auto rule = make_shared<TimerRule>();
+  rule->callback = callback;
+  rule->interval_ms = repeat ? max<int64_t>( delay.count(), 1 ) : 0;
+  rule->timer = timers_.create( rule );
+  rule->detach = [this, id = rule->timer] { timers_.destroy( id ); };
+  timers_.schedule( rule->timer, elapsed_ms() + max<int64_t>( delay.count(), 0 ) );
+  return RuleHandle { rule };
+}
+
+// Bring the epoll set up to date with the rules on `fd` that want events, and forget the descriptor
+// once it has no rules left
+void EventLoop::update( const int fd )
+{
+  Registration* reg = registrations_.find( fd );
+  if ( not reg ) {
+    return;
+  }
+
+  auto wanted = []( const shared_ptr<FDRule>& rule ) -> uint32_t {
+    if ( not rule or rule->parked ) {
+      return 0;
+    }
+    return static_cast<uint32_t>( rule->direction ) | ( rule->trigger == Trigger::Edge ? uint32_t { EPOLLET } : 0 );
+  };
+  // A descriptor closed behind the loop's back has already left the epoll set, and its number may have been
+  // reused since, so it is left alone until its rules are cancelled
+  const bool closed = ( reg->in and reg->in->fd.closed() ) or ( reg->out and reg->out->fd.closed() );
+  const uint32_t events = closed ? 0 : wanted( reg->in ) | wanted( reg->out );
+
+  if ( events != reg->events ) {
+    const int op = reg->events == 0 ? EPOLL_CTL_ADD : events == 0 ? EPOLL_CTL_DEL : EPOLL_CTL_MOD;
+    epoll_event event { .events = events,
+                        .data = { .u64 = uint64_t { reg->generation } << 32 | static_cast<uint32_t>( fd ) } };
+    if ( not closed and ::epoll_ctl( epoll_.fd_num(), op, fd, &event ) < 0
+         and not( op == EPOLL_CTL_DEL and ( errno == EBADF or errno == ENOENT ) ) ) {
+      throw unix_error { "epoll_ctl" };
+    }
+    n_watched_ += ( op == EPOLL_CTL_ADD );
+    n_watched_ -= ( op == EPOLL_CTL_DEL );
+    reg->events = events;
+  }
+
+  if ( not reg->in and not reg->out ) {
+    registrations_.erase( fd );
+  }
+}
+
+void EventLoop::remove( const int fd, const Direction direction )
+{
+  Registration* reg = registrations_.find( fd );
+  if ( not reg ) {
+    return;
+  }
+  ( direction == Direction::In ? reg->in : reg->out ).reset();
+  update( fd );
+}
+
+void EventLoop::dispatch( const epoll_event& event )
+{
+  const int fd = static_cast<int>( event.data.u64 & 0xffffffff );
+  const auto generation = static_cast<uint32_t>( event.data.u64 >> 32 );
+  const bool hangup = event.events & ( EPOLLERR | EPOLLHUP );
+
+  for ( const Direction direction : { Direction::In, Direction::Out } ) {
+    // Looked up afresh for each direction, since the first callback may cancel rules or add new ones
+    const Registration* reg = registrations_.find( fd );
+    if ( not reg or reg->generation != generation ) {
+      return;
+    }
+    const shared_ptr<FDRule> rule = direction == Direction::In ? reg->in : reg->out; // alive through the callback
+    if ( not rule or rule->parked or not( hangup or ( event.events & static_cast<uint32_t>( direction ) ) ) ) {
+      continue;
+    }
+
+    // Nothing more can be written after a hangup or error (a read will report it, so In rules still run)
+    if ( direction == Direction::Out and hangup ) {
+      cancel_rule( *rule );
+      continue;
+    }
+
+    if ( rule->interest and not rule->interest() ) {
+      rule->parked = true;
+      update( fd );
+      continue;
+    }
+
+    rule->callback();
+
+    if ( rule->fd.closed() or ( direction == Direction::In and rule->fd.eof() ) ) {
+      cancel_rule( *rule );
+    }
+  }
+}
+
+// Put a parked rule back into the epoll set, if it is interested again
+void EventLoop::unpark( FDRule& rule )
+{
+  if ( rule.cancelled or not rule.parked or rule.fd.closed() or not rule.interest() ) {
+    return;
+  }
+  rule.parked = false;
+  update( rule.fd.fd_num() );
+}
+
+// Cancel the rules on a descriptor that has been closed outside their own callbacks. The kernel has taken it
+// out of the epoll set already, so no event would ever come along to cancel them.
+void EventLoop::cancel_if_closed( const Registration& reg )
+{
+  // Held here, since cancelling the first may erase `reg`
+  const shared_ptr<FDRule> in = reg.in;
+  const shared_ptr<FDRule> out = reg.out;
+  for ( const auto& rule : { in, out } ) {
+    if ( rule and rule->fd.closed() ) {
+      cancel_rule( *rule );
+    }
+  }
+}
+
+// The same for every descriptor closed since the last wait (including any closed by the cancel callbacks)
+void EventLoop::cancel_closed()
+{
+  while ( not closed_.empty() ) {
+    for ( const auto& closed : exchange( closed_, {} ) ) {
+      if ( const shared_ptr<FDRule> rule = closed.lock() ) {
+        cancel_rule( *rule );
+      }
+    }
+  }
+}
+
+// Run the timers that are due; returns whether any did
+bool EventLoop::run_timers()
+{
+  bool ran = false;
+  timers_.advance( elapsed_ms() - timers_.now(), [&]( uint32_t id, const shared_ptr<TimerRule>& rule ) {
+    if ( rule->cancelled ) {
+      return;
+    }
+    ran = true;
+    rule->callback();
+    if ( rule->cancelled ) {
+      return;
+    }
+    if ( rule->interval_ms ) {
+      timers_.schedule( id, timers_.now() + rule->interval_ms );
+    } else {
+      cancel_rule( *rule );
+    }
+  } );
+  return ran;
+}
+
+uint64_t EventLoop::elapsed_ms() const
+{
+  return chrono::duration_cast<chrono::milliseconds>( chrono::steady_clock::now() - start_ ).count();
+}
+
+EventLoop::Result EventLoop::wait_next_event( const int timeout_ms )
+{
+  cancel_closed();
+  if ( n_watched_ == 0 and timers_.empty() ) {
+    return Result::Exit;
+  }
+
+  // Wake up in time for the next timer
+  int wait = timeout_ms;
+  if ( not timers_.empty() ) {
+    const uint64_t now = elapsed_ms();
+    const uint64_t next = timers_.next_expiry();
+    const int until_next = next <= now ? 0 : static_cast<int>( min<uint64_t>( next - now, INT_MAX ) );
+    wait = wait < 0 ? until_next : min( wait, until_next );
+  }
+
+  const int n_events = ::epoll_wait( epoll_.fd_num(), events_.data(), static_cast<int>( events_.size() ), wait );
+  if ( n_events < 0 and errno != EINTR ) {
+    throw unix_error { "epoll_wait" };
+  }
+  for ( int i = 0; i < n_events; i++ ) {
+    dispatch( events_[i] );
+  }
+
+  const bool timers_ran = run_timers();
+  return n_events > 0 or timers_ran ? Result::Success : Result::Timeout;
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include "file_descriptor.hh"
+#include "flat_hash_map.hh"
+#include "timer_wheel.hh"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <sys/epoll.h>
+#include <vector>
+
+// Waits for events on many file descriptors at once (with epoll), and calls back the rules that asked for them.
+//
+// A rule ties a file descriptor and a direction to a callback, which runs whenever the descriptor is ready
+// in that direction. An optional interest predicate says whether the rule wants events at all right now. It
+// is asked when the rule is added and when an event arrives; once it returns false the rule is parked, out
+// of the epoll set, until its RuleHandle's wake() finds it interested again. Timer rules run a callback after
+// a delay, once or repeatedly.
+//
+// A wait costs only the events and timers that are due, and the descriptors closed since the last one: idle,
+// parked and closed sockets are not looked at.
+//
+// Everything happens on the thread that calls wait_next_event().
+class EventLoop
+{
+public:
+  enum class Direction : uint32_t
+  {
+    In = EPOLLIN,  // callback when the descriptor is readable
+    Out = EPOLLOUT // callback when the descriptor is writable
+  };
+
+  // Level-triggered callbacks run on every wait while the descriptor stays ready. Edge-triggered ones run
+  // only when it becomes ready, so they must drain it (read or write until EAGAIN) each time.
+  enum class Trigger
+  {
+    Level,
+    Edge
+  };
+
+  enum class Result
+  {
+    Success, // some callback ran
+    Timeout, // nothing happened before the timeout
+    Exit     // no rule is left that could ever run
+  };
+
+  using CallbackT = std::function<void( void )>;
+  using InterestT = std::function<bool( void )>;
+
+private:
+  struct Rule
+  {
+    CallbackT callback {};
+    CallbackT on_cancel {};
+    bool cancelled {};
+    CallbackT detach {}; // removes the rule from the loop (installed by the loop)
+    CallbackT wake {};   // asks a parked rule's interest again (installed by the loop, on descriptor rules)
+  };
+
+  struct FDRule : Rule
+  {
+    FileDescriptor fd;
+    Direction direction;
+    Trigger trigger;
+    InterestT interest;  // empty means always interested
+    bool parked {};      // out of the epoll set until woken with interest() returning true
+    CallbackT closed {}; // called back when `fd` is closed
+
+    FDRule( FileDescriptor&& fd_, Direction direction_, Trigger trigger_, InterestT interest_ )
+      : fd( std::move( fd_ ) ), direction( direction_ ), trigger( trigger_ ), interest( std::move( interest_ ) )
+    {}
+  };
+
+  struct TimerRule : Rule
+  {
+    uint64_t interval_ms {}; // 0 for a one-shot timer
+    uint32_t timer {};
+  };
+
+  // The rules on one descriptor, and what it is registered for in the epoll set
+  struct Registration
+  {
+    std::shared_ptr<FDRule> in {};
+    std::shared_ptr<FDRule> out {};
+    uint32_t events {};     // registered events (0 when not in the epoll set)
+    uint32_t generation {}; // tells apart registrations of a reused descriptor number
+  };
+
+  FileDescriptor epoll_;
+  FlatHashMap<int, Registration> registrations_ {};
+  uint32_t next_generation_ {};
+  size_t n_watched_ {}; // descriptors in the epoll set
+  std::vector<std::weak_ptr<FDRule>> closed_ {}; // rules whose descriptors were closed since the last wait
+  std::array<epoll_event, 256> events_ {};
+
+  TimerWheel<std::shared_ptr<TimerRule>> timers_ {};
+  std::chrono::steady_clock::time_point start_ { std::chrono::steady_clock::now() };
+
+  void update( int fd );
+  void remove( int fd, Direction direction );
+  void dispatch( const epoll_event& event );
+  void unpark( FDRule& rule );
+  void cancel_if_closed( const Registration& reg );
+  void cancel_closed();
+  bool run_timers();
+  uint64_t elapsed_ms() const;
+
+  static void cancel_rule( Rule& rule );
+
+public:
+  EventLoop();
+
+  // Cancels or wakes a rule (a no-op if it has already been cancelled, or its EventLoop is gone)
+  class RuleHandle
+  {
+    std::weak_ptr<Rule> rule_ {};
+
+  public:
+    RuleHandle() = default;
+    explicit RuleHandle( std::weak_ptr<Rule> rule ) : rule_( std::move( rule ) ) {}
+    void cancel();
+
+    // Ask a parked rule's interest predicate again, and have it wait for events if it is now interested
+    // (a no-op for a rule that is not parked)
+    void wake();
+  };
+
+  // Call `callback` whenever `fd` is ready in `direction` (and `interest` returns true, see above). A
+  // descriptor has at most one rule per direction. The rule is cancelled, and `cancel` called, once the
+  // descriptor is closed or reaches EOF (or on a hangup or error, for Out rules).
+  RuleHandle add_rule(
+    const FileDescriptor& fd,
+    Direction direction,
+    const CallbackT& callback,
+    const InterestT& interest = {},
+    const CallbackT& cancel = [] {},
+    Trigger trigger = Trigger::Level );
+
+  // Call `callback` after `delay`, and then every `delay` if `repeat`
+  RuleHandle add_timer( std::chrono::milliseconds delay, const CallbackT& callback, bool repeat = false );
+
+  // Wait for events (at most `timeout_ms`, or indefinitely if negative) and run the callbacks of the rules
+  // they concern, along with any timers that are due
+  Result wait_next_event( int timeout_ms );
+
+  EventLoop( const EventLoop& other ) = delete;
+  EventLoop& operator=( const EventLoop& other ) = delete;
+  ~EventLoop() = default;
+};
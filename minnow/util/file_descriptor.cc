@@ -3,6 +3,7 @@
 #include "exception.hh"
 
 #include <algorithm>
+#include <climits>
 #include <fcntl.h>
 #include <iostream>
 #include <stdexcept>
@@ -10,6 +11,7 @@
 #include <sys/types.h>
 #include <sys/uio.h>
 #include <unistd.h>
+#include <utility>
 
 using namespace std;
 
@@ -51,6 +53,11 @@ void FileDescriptor::FDWrapper::close()
 {
   CheckSystemCall( "close", ::close( fd_ ) );
   eof_ = closed_ = true;
+  for ( const auto& watcher : exchange( close_watchers_, {} ) ) {
+    if ( const auto callback = watcher.lock() ) {
+      ( *callback )();
+    }
+  }
 }
 
 FileDescriptor::FDWrapper::~FDWrapper()
@@ -69,6 +76,12 @@ FileDescriptor::FDWrapper::~FDWrapper()
 // fd is the file descriptor number returned by [open(2)](\ref man2::open) or similar
 FileDescriptor::FileDescriptor( int fd ) : internal_fd_( make_shared<FDWrapper>( fd ) ) {}
 
+void FileDescriptor::watch_close( const shared_ptr<const function<void()>>& callback )
+{
+  erase_if( internal_fd_->close_watchers_, []( const auto& watcher ) { return watcher.expired(); } );
+  internal_fd_->close_watchers_.emplace_back( callback );
+}
+
 // Private constructor used by duplicate()
 FileDescriptor::FileDescriptor( shared_ptr<FDWrapper> other_shared_ptr ) : internal_fd_( move( other_shared_ptr ) )
 {}
@@ -79,16 +92,26 @@ FileDescriptor FileDescriptor::duplicate() const
   return FileDescriptor { internal_fd_ };
 }
 
-// buffer is the string to be read into
-void FileDescriptor::read( string& buffer )
+// Reads land here before being copied out to a caller's string. Unlike resizing the string to the full read
+// size first, this is never zero-filled, so a short read costs only the bytes it returns. One per thread
+// rather than per descriptor, since a thread can be reading from thousands of sockets.
+span<char> FileDescriptor::read_scratch()
 {
-  buffer.clear();
-  buffer.resize( kReadBufferSize );
+  thread_local const unique_ptr<char[]> scratch = make_unique_for_overwrite<char[]>( kReadBufferSize );
+  return { scratch.get(), kReadBufferSize };
+}
+
+size_t FileDescriptor::read( span<char> buffer )
+{
+  // A zero-length read returns 0 whether or not the stream has ended, so it must not be taken for EOF
+  if ( buffer.empty() ) {
+    return 0;
+  }
 
   const ssize_t bytes_read = ::read( fd_num(), buffer.data(), buffer.size() );
   if ( bytes_read < 0 ) {
     if ( internal_fd_->non_blocking_ and ( errno == EAGAIN or errno == EINPROGRESS ) ) {
-      return;
+      return 0;
     }
     throw unix_error { "read" };
   }
@@ -103,25 +126,32 @@ void FileDescriptor::read( string& buffer )
     throw runtime_error( "read() read more than requested" );
   }
 
-  buffer.resize( bytes_read );
+  return bytes_read;
 }
 
+// buffer is the string to be read into
+void FileDescriptor::read( string& buffer )
+{
+  const span<char> scratch = read_scratch();
+  buffer.assign( scratch.data(), read( scratch ) );
+}
+
+// Fills the buffers in order, up to their current sizes, except the last, which gets up to kReadBufferSize
 void FileDescriptor::read( vector<unique_ptr<string>>& buffers )
 {
   if ( buffers.empty() ) {
     return;
   }
 
-  buffers.back()->clear();
-  buffers.back()->resize( kReadBufferSize );
-
+  const span<char> scratch = read_scratch();
   vector<iovec> iovecs;
   iovecs.reserve( buffers.size() );
-  size_t total_size = 0;
-  for ( const auto& x : buffers ) {
-    iovecs.push_back( { const_cast<char*>( x->data() ), x->size() } ); // NOLINT(*-const-cast)
-    total_size += x->size();
+  size_t total_size = scratch.size();
+  for ( size_t i = 0; i + 1 < buffers.size(); i++ ) {
+    iovecs.push_back( { buffers[i]->data(), buffers[i]->size() } );
+    total_size += buffers[i]->size();
   }
+  iovecs.push_back( { scratch.data(), scratch.size() } );
 
   const ssize_t bytes_read = ::readv( fd_num(), iovecs.data(), static_cast<int>( iovecs.size() ) );
   if ( bytes_read < 0 ) {
@@ -138,16 +168,12 @@ void FileDescriptor::read( vector<unique_ptr<string>>& buffers )
   }
 
   size_t remaining_size = bytes_read;
-  for ( auto& buf : buffers ) {
-    if ( remaining_size <= buf->size() ) {
-      remaining_size -= buf->size();
-    } else if ( remaining_size == 0 ) {
-      buf->clear();
-    } else {
-      buf->resize( remaining_size );
-      remaining_size = 0;
-    }
+  for ( size_t i = 0; i + 1 < buffers.size(); i++ ) {
+    const size_t filled = min( remaining_size, buffers[i]->size() );
+    buffers[i]->resize( filled );
+    remaining_size -= filled;
   }
+  buffers.back()->assign( scratch.data(), remaining_size );
 }
 
 size_t FileDescriptor::write( string_view buffer )
@@ -159,10 +185,51 @@ size_t FileDescriptor::write( const vector<string_view>& buffers )
 {
   vector<iovec> iovecs;
   iovecs.reserve( buffers.size() );
-  size_t total_size = 0;
   for ( const auto x : buffers ) {
     iovecs.push_back( { const_cast<char*>( x.data() ), x.size() } ); // NOLINT(*-const-cast)
-    total_size += x.size();
+  }
+  return write_iovecs( iovecs );
+}
+
+size_t FileDescriptor::write( const BufferChain& buffers )
+{
+  return write_iovecs( buffers.iovecs() );
+}
+
+// Fill the Buffers of `buffers` in order, then truncate the chain to the bytes read
+void FileDescriptor::read( BufferChain& buffers )
+{
+  for ( const auto& buffer : buffers ) {
+    if ( not buffer.empty() and not buffer.unique() ) {
+      throw runtime_error( "read() into a shared Buffer" );
+    }
+  }
+
+  const span<const iovec> iovecs = buffers.iovecs().first( min( buffers.size(), size_t { IOV_MAX } ) );
+  const ssize_t bytes_read = ::readv( fd_num(), iovecs.data(), static_cast<int>( iovecs.size() ) );
+  if ( bytes_read < 0 ) {
+    if ( internal_fd_->non_blocking_ and ( errno == EAGAIN or errno == EINPROGRESS ) ) {
+      buffers.clear();
+      return;
+    }
+    throw unix_error { "read" };
+  }
+
+  register_read();
+
+  if ( bytes_read == 0 and buffers.length() != 0 ) {
+    internal_fd_->eof_ = true;
+  }
+
+  buffers.truncate( bytes_read );
+}
+
+size_t FileDescriptor::write_iovecs( span<const iovec> iovecs )
+{
+  iovecs = iovecs.first( min( iovecs.size(), size_t { IOV_MAX } ) );
+  size_t total_size = 0;
+  for ( const auto& x : iovecs ) {
+    total_size += x.iov_len;
   }
 
   const ssize_t bytes_written
@@ -1,8 +1,13 @@
 #pragma once
 
+#include "buffer_chain.hh"
+
 #include <cstddef>
+#include <functional>
 #include <limits>
 #include <memory>
+#include <span>
+#include <sys/uio.h>
 #include <vector>
 
 // A reference-counted handle to a file descriptor
@@ -19,6 +24,7 @@ class FileDescriptor
     bool non_blocking_ = false; // Flag indicating whether FDWrapper::fd_ is non-blocking
     unsigned read_count_ = 0;   // The number of times FDWrapper::fd_ has been read
     unsigned write_count_ = 0;  // The numberof times FDWrapper::fd_ has been written
+    std::vector<std::weak_ptr<const std::function<void()>>> close_watchers_ {}; // called back by close()
 
     // Construct from a file descriptor number returned by the kernel
     explicit FDWrapper( int fd );
@@ -47,6 +53,9 @@ protected:
   // size of buffer to allocate for read()
   static constexpr size_t kReadBufferSize = 16384;
 
+  // kReadBufferSize bytes of uninitialized storage, reused by every read into a std::string on this thread
+  static std::span<char> read_scratch();
+
   void set_eof() { internal_fd_->eof_ = true; }
   void register_read() { ++internal_fd_->read_count_; }   // increment read count
   void register_write() { ++internal_fd_->write_count_; } // increment write count
@@ -54,6 +63,9 @@ protected:
   template<typename T>
   T CheckSystemCall( std::string_view s_attempt, T return_value ) const;
 
+  // writev() the given iovecs (at most IOV_MAX of them); returns number of bytes written
+  size_t write_iovecs( std::span<const iovec> iovecs );
+
 public:
   // Construct from a file descriptor number returned by the kernel
   explicit FileDescriptor( int fd );
@@ -63,16 +75,31 @@ public:
 
   // Read into `buffer`
   void read( std::string& buffer );
+
+  // Read into caller-provided storage, which is not touched beyond the bytes read; returns how many
+  // (0 at EOF, if a non-blocking descriptor has nothing to read, or if `buffer` is empty)
+  size_t read( std::span<char> buffer );
+
   void read( std::vector<std::unique_ptr<std::string>>& buffers );
 
+  // Read straight into the Buffers of a chain (each unique, e.g. from Buffer::uninitialized), and
+  // truncate the chain to the bytes that arrived
+  void read( BufferChain& buffers );
+
   // Attempt to write a buffer
   // returns number of bytes written
   size_t write( std::string_view buffer );
   size_t write( const std::vector<std::string_view>& buffers );
 
+  // Write a chain of Buffers with one writev(), without flattening it
+  size_t write( const BufferChain& buffers );
+
   // Close the underlying file descriptor
   void close() { internal_fd_->close(); }
 
+  // Call `*callback` once the descriptor is closed with close(), if `callback` is still alive by then
+  void watch_close( const std::shared_ptr<const std::function<void()>>& callback );
+
   // Copy a FileDescriptor explicitly, increasing the FDWrapper refcount
   FileDescriptor duplicate() const;
 
@@ -0,0 +1,231 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#if defined( __SSE2__ )
+#include <emmintrin.h>
+#endif
+
+// Default hash for FlatHashMap: a full-avalanche mix of integral keys (the low bits pick the
+// group and the high bits tag the slot, so both need to be well distributed).
+template<typename K>
+struct FlatHash
+{
+  size_t operator()( const K& key ) const
+  {
+    uint64_t x = static_cast<uint64_t>( key );
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+  }
+};
+
+// An open-addressing hash map with keys and values stored inline in one flat array.
+//
+// Slots are organized in groups of 16, each with a byte of metadata (empty, deleted, or
+// seven bits of the key's hash). A lookup loads a group's 16 metadata bytes at once (with
+// SSE2 where available) and compares the key only in slots whose tag matches, so most
+// lookups touch one metadata line and one slot.
+//
+// Pointers returned by find() and try_emplace() are invalidated by any later insertion.
+template<typename K, typename V, typename Hash = FlatHash<K>>
+class FlatHashMap
+{
+public:
+  struct Slot
+  {
+    K key {};
+    V value {};
+  };
+
+private:
+  static constexpr size_t GROUP = 16;
+  static constexpr int8_t EMPTY = -128;
+  static constexpr int8_t DELETED = -2;
+
+  std::vector<int8_t> ctrl_ {};
+  std::vector<Slot> slots_ {};
+  size_t size_ {};
+  size_t deleted_ {};
+  [[no_unique_address]] Hash hash_ {};
+
+  // Bitmask of the slots in the group starting at `group` whose metadata byte equals `tag`
+  static uint32_t match( const int8_t* group, int8_t tag )
+  {
+#if defined( __SSE2__ )
+    const __m128i ctrl = _mm_loadu_si128( reinterpret_cast<const __m128i*>( group ) ); // NOLINT(*-reinterpret-cast)
+    return static_cast<uint32_t>( _mm_movemask_epi8( _mm_cmpeq_epi8( ctrl, _mm_set1_epi8( tag ) ) ) );
+#else
+    uint32_t mask = 0;
+    for ( size_t i = 0; i < GROUP; i++ ) {
+      mask |= static_cast<uint32_t>( group[i] == tag ) << i;
+    }
+    return mask;
+#endif
+  }
+
+  size_t n_groups() const { return ctrl_.size() / GROUP; }
+  static int8_t tag_of( size_t hash ) { return static_cast<int8_t>( hash >> ( 64 - 7 ) ); }
+
+  // Index of the slot holding `key`, or ctrl_.size() if absent
+  size_t find_index( const K& key ) const
+  {
+    if ( ctrl_.empty() ) {
+      return 0;
+    }
+
+    const size_t hash = hash_( key );
+    const int8_t tag = tag_of( hash );
+    const size_t mask = n_groups() - 1;
+    size_t group = hash & mask;
+    for ( size_t probe = 1;; probe++ ) {
+      const int8_t* ctrl = &ctrl_[group * GROUP];
+      for ( uint32_t hits = match( ctrl, tag ); hits; hits &= hits - 1 ) {
+        const size_t index = group * GROUP + std::countr_zero( hits );
+        if ( slots_[index].key == key ) {
+          return index;
+        }
+      }
+      if ( match( ctrl, EMPTY ) or probe > n_groups() ) {
+        return ctrl_.size();
+      }
+      group = ( group + probe ) & mask; // triangular probing visits every group
+    }
+  }
+
+  // Index of a free (empty or deleted) slot for a key with `hash`
+  size_t free_index( size_t hash ) const
+  {
+    const size_t mask = n_groups() - 1;
+    size_t group = hash & mask;
+    for ( size_t probe = 1;; probe++ ) {
+      const int8_t* ctrl = &ctrl_[group * GROUP];
+      const uint32_t free = match( ctrl, EMPTY ) | match( ctrl, DELETED );
+      if ( free ) {
+        return group * GROUP + std::countr_zero( free );
+      }
+      group = ( group + probe ) & mask;
+    }
+  }
+
+  void rehash( size_t capacity )
+  {
+    std::vector<int8_t> old_ctrl( capacity, EMPTY );
+    std::vector<Slot> old_slots( capacity );
+    std::swap( old_ctrl, ctrl_ );
+    std::swap( old_slots, slots_ );
+    deleted_ = 0;
+
+    for ( size_t i = 0; i < old_ctrl.size(); i++ ) {
+      if ( old_ctrl[i] >= 0 ) {
+        const size_t hash = hash_( old_slots[i].key );
+        const size_t index = free_index( hash );
+        ctrl_[index] = tag_of( hash );
+        slots_[index] = std::move( old_slots[i] );
+      }
+    }
+  }
+
+public:
+  FlatHashMap() = default;
+
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  size_t capacity() const { return ctrl_.size(); }
+
+  // Make room for `n` entries without further rehashing
+  void reserve( size_t n )
+  {
+    const size_t needed = std::bit_ceil( std::max( GROUP, ( n * 8 + 6 ) / 7 ) );
+    if ( needed > capacity() ) {
+      rehash( needed );
+    }
+  }
+
+  V* find( const K& key )
+  {
+    const size_t index = find_index( key );
+    return index < ctrl_.size() ? &slots_[index].value : nullptr;
+  }
+
+  const V* find( const K& key ) const
+  {
+    const size_t index = find_index( key );
+    return index < ctrl_.size() ? &slots_[index].value : nullptr;
+  }
+
+  bool contains( const K& key ) const { return find_index( key ) < ctrl_.size(); }
+
+  // Returns the value for `key` (default-constructed if newly inserted) and whether it was inserted
+  std::pair<V*, bool> try_emplace( const K& key )
+  {
+    if ( V* existing = find( key ) ) {
+      return { existing, false };
+    }
+
+    // Keep the table at most 7/8 full, counting tombstones
+    if ( ( size_ + deleted_ + 1 ) * 8 > capacity() * 7 ) {
+      rehash( size_ * 2 + 2 > capacity() ? std::max( GROUP, capacity() * 2 ) : capacity() );
+    }
+
+    const size_t hash = hash_( key );
+    const size_t index = free_index( hash );
+    if ( ctrl_[index] == DELETED ) {
+      deleted_--;
+    }
+    ctrl_[index] = tag_of( hash );
+    slots_[index] = Slot { key, V {} };
+    size_++;
+    return { &slots_[index].value, true };
+  }
+
+  V& operator[]( const K& key ) { return *try_emplace( key ).first; }
+
+  bool erase( const K& key )
+  {
+    const size_t index = find_index( key );
+    if ( index >= ctrl_.size() ) {
+      return false;
+    }
+
+    // A group that still has an empty slot has never been full, so no probe sequence runs
+    // through it and the slot can go straight back to empty
+    const int8_t* group = &ctrl_[index / GROUP * GROUP];
+    if ( match( group, EMPTY ) ) {
+      ctrl_[index] = EMPTY;
+    } else {
+      ctrl_[index] = DELETED;
+      deleted_++;
+    }
+    slots_[index] = Slot {};
+    size_--;
+    return true;
+  }
+
+  void clear()
+  {
+    ctrl_.clear();
+    slots_.clear();
+    size_ = deleted_ = 0;
+  }
+
+  // Call `f( key, value )` for every entry
+  template<typename F>
+  void for_each( F&& f )
+  {
+    for ( size_t i = 0; i < ctrl_.size(); i++ ) {
+      if ( ctrl_[i] >= 0 ) {
+        f( std::as_const( slots_[i].key ), slots_[i].value );
+      }
+    }
+  }
+};
@@ -0,0 +1,163 @@
+#pragma once
+
+#include "parser.hh"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+// Describe a fixed-layout header as its fields in wire order, and get a codec for it that checks the
+// input length once and then encodes or decodes every field with straight-line code:
+//
+//   using Layout = HeaderLayout<Field<&IPv4Header::ver, 4>, Field<&IPv4Header::hlen, 4>, ...>;
+//   Layout::parse( header, parser );       // or Layout::decode( header, bytes )
+//   Layout::serialize( header, serializer ); // or Layout::encode( header, bytes )
+//
+// Field widths are in bits, so fields that share a byte (version/IHL, flags/fragment offset) are
+// described the same way as whole-byte ones. Multi-byte values are big-endian.
+
+template<class T>
+struct MemberType;
+
+template<class C, class M>
+struct MemberType<M C::*>
+{
+  using type = M;
+};
+
+// An integer (or bool) member stored in `Bits` bits
+template<auto Member, size_t Bits>
+struct Field
+{
+  static_assert( Bits > 0 and Bits <= 57, "a field must fit in eight bytes wherever it starts" );
+  static constexpr size_t BITS = Bits;
+  static constexpr uint64_t MASK = ( uint64_t { 1 } << Bits ) - 1;
+
+  // The bytes holding a field that starts `Offset` bits into the header, and where in them it sits
+  template<size_t Offset>
+  struct Position
+  {
+    static constexpr size_t FIRST = Offset / 8;
+    static constexpr size_t N_BYTES = ( Offset % 8 + Bits + 7 ) / 8;
+    static constexpr size_t SHIFT = N_BYTES * 8 - Offset % 8 - Bits;
+  };
+
+  template<size_t Offset, class Header>
+  static void decode( Header& header, const uint8_t* in )
+  {
+    using P = Position<Offset>;
+    uint64_t window = 0;
+    for ( size_t i = 0; i < P::N_BYTES; i++ ) {
+      window = window << 8 | in[P::FIRST + i];
+    }
+    using T = typename MemberType<decltype( Member )>::type;
+    header.*Member = static_cast<T>( ( window >> P::SHIFT ) & MASK );
+  }
+
+  // Values too wide for the field are truncated to its width. `out` starts zeroed.
+  template<size_t Offset, class Header>
+  static void encode( const Header& header, uint8_t* out )
+  {
+    using P = Position<Offset>;
+    const uint64_t window = ( static_cast<uint64_t>( header.*Member ) & MASK ) << P::SHIFT;
+    for ( size_t i = 0; i < P::N_BYTES; i++ ) {
+      out[P::FIRST + i] |= static_cast<uint8_t>( window >> ( 8 * ( P::N_BYTES - 1 - i ) ) );
+    }
+  }
+};
+
+// A byte-array member (e.g. an EthernetAddress), copied as is
+template<auto Member>
+struct Bytes
+{
+  static constexpr size_t BITS = sizeof( typename MemberType<decltype( Member )>::type ) * 8;
+
+  template<size_t Offset, class Header>
+  static void decode( Header& header, const uint8_t* in )
+  {
+    static_assert( Offset % 8 == 0, "byte arrays must start on a byte boundary" );
+    std::memcpy( ( header.*Member ).data(), in + Offset / 8, BITS / 8 );
+  }
+
+  template<size_t Offset, class Header>
+  static void encode( const Header& header, uint8_t* out )
+  {
+    std::memcpy( out + Offset / 8, ( header.*Member ).data(), BITS / 8 );
+  }
+};
+
+// Bits that are ignored when parsing and sent as zero
+template<size_t Bits>
+struct Reserved
+{
+  static constexpr size_t BITS = Bits;
+
+  template<size_t Offset, class Header>
+  static void decode( Header& /* header */, const uint8_t* /* in */ )
+  {}
+
+  template<size_t Offset, class Header>
+  static void encode( const Header& /* header */, uint8_t* /* out */ )
+  {}
+};
+
+template<class... Fields>
+class HeaderLayout
+{
+  static constexpr size_t BITS = ( Fields::BITS + ... );
+  static_assert( BITS % 8 == 0, "a header must be a whole number of bytes" );
+
+  // Bit offset of each field: the sum of the widths before it
+  static constexpr std::array<size_t, sizeof...( Fields )> OFFSETS = [] {
+    std::array<size_t, sizeof...( Fields )> offsets {};
+    const std::array<size_t, sizeof...( Fields )> widths { Fields::BITS... };
+    for ( size_t i = 1; i < offsets.size(); i++ ) {
+      offsets[i] = offsets[i - 1] + widths[i - 1];
+    }
+    return offsets;
+  }();
+
+public:
+  static constexpr size_t LENGTH = BITS / 8;
+
+  // Decode from exactly LENGTH bytes
+  template<class Header>
+  static void decode( Header& header, std::string_view in )
+  {
+    const auto* bytes = reinterpret_cast<const uint8_t*>( in.data() ); // NOLINT(*-reinterpret-cast)
+    [&]<size_t... I>( std::index_sequence<I...> ) {
+      ( Fields::template decode<OFFSETS[I]>( header, bytes ), ... );
+    }( std::index_sequence_for<Fields...> {} );
+  }
+
+  // Encode into exactly LENGTH bytes
+  template<class Header>
+  static void encode( const Header& header, char* out )
+  {
+    auto* bytes = reinterpret_cast<uint8_t*>( out ); // NOLINT(*-reinterpret-cast)
+    std::memset( bytes, 0, LENGTH );
+    [&]<size_t... I>( std::index_sequence<I...> ) {
+      ( Fields::template encode<OFFSETS[I]>( header, bytes ), ... );
+    }( std::index_sequence_for<Fields...> {} );
+  }
+
+  template<class Header>
+  static void parse( Header& header, Parser& parser )
+  {
+    std::array<char, LENGTH> scratch; // NOLINT(*-member-init)
+    const std::string_view in = parser.contiguous( scratch );
+    if ( not parser.has_error() ) {
+      decode( header, in );
+    }
+  }
+
+  template<class Header>
+  static void serialize( const Header& header, Serializer& serializer )
+  {
+    encode( header, serializer.room( LENGTH ) );
+  }
+};
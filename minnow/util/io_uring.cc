@@ -0,0 +1,228 @@
+#include "io_uring.hh"
+
+#include "exception.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace {
+
+int io_uring_setup( unsigned entries, io_uring_params& params )
+{
+  return static_cast<int>( ::syscall( __NR_io_uring_setup, entries, &params ) );
+}
+
+int io_uring_enter( int fd, unsigned to_submit, unsigned min_complete, unsigned flags )
+{
+  return static_cast<int>( ::syscall( __NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0 ) );
+}
+
+int io_uring_register( int fd, unsigned opcode, const void* arg, unsigned nr_args )
+{
+  return static_cast<int>( ::syscall( __NR_io_uring_register, fd, opcode, arg, nr_args ) );
+}
+
+void* map_ring( int fd, size_t size, off_t offset )
+{
+  void* ring = ::mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset );
+  if ( ring == MAP_FAILED ) {
+    throw unix_error { "mmap" };
+  }
+  return ring;
+}
+
+// The ring indices are shared with the kernel: each side publishes its own with a release store and reads
+// the other's with an acquire load
+unsigned load_acquire( const unsigned* index )
+{
+  return atomic_ref<const unsigned>( *index ).load( memory_order_acquire );
+}
+
+void store_release( unsigned* index, unsigned value )
+{
+  atomic_ref<unsigned>( *index ).store( value, memory_order_release );
+}
+
+template<typename T>
+T* at( void* base, size_t offset )
+{
+  return reinterpret_cast<T*>( static_cast<char*>( base ) + offset ); // NOLINT(*-reinterpret-cast)
+}
+
+} // namespace
+
+IOUring::IOUring( unsigned entries )
+  : ring_( CheckSystemCall( "io_uring_setup", io_uring_setup( entries, params_ ) ) )
+{
+  sq_ring_size_ = params_.sq_off.array + params_.sq_entries * sizeof( unsigned );
+  cq_ring_size_ = params_.cq_off.cqes + params_.cq_entries * sizeof( io_uring_cqe );
+
+  // Recent kernels map both rings with one mmap
+  if ( params_.features & IORING_FEAT_SINGLE_MMAP ) {
+    sq_ring_size_ = cq_ring_size_ = max( sq_ring_size_, cq_ring_size_ );
+  }
+  sq_ring_ = map_ring( ring_.fd_num(), sq_ring_size_, IORING_OFF_SQ_RING );
+  if ( params_.features & IORING_FEAT_SINGLE_MMAP ) {
+    cq_ring_ = sq_ring_;
+  } else {
+    cq_ring_ = map_ring( ring_.fd_num(), cq_ring_size_, IORING_OFF_CQ_RING );
+  }
+  sqes_ = static_cast<io_uring_sqe*>(
+    map_ring( ring_.fd_num(), params_.sq_entries * sizeof( io_uring_sqe ), IORING_OFF_SQES ) );
+
+  sq_tail_ = at<unsigned>( sq_ring_, params_.sq_off.tail );
+  sq_head_ = at<unsigned>( sq_ring_, params_.sq_off.head );
+  sq_mask_ = *at<unsigned>( sq_ring_, params_.sq_off.ring_mask );
+  sq_array_ = at<unsigned>( sq_ring_, params_.sq_off.array );
+  cq_head_ = at<unsigned>( cq_ring_, params_.cq_off.head );
+  cq_tail_ = at<unsigned>( cq_ring_, params_.cq_off.tail );
+  cq_mask_ = *at<unsigned>( cq_ring_, params_.cq_off.ring_mask );
+  cqes_ = at<io_uring_cqe>( cq_ring_, params_.cq_off.cqes );
+}
+
+IOUring::~IOUring()
+{
+  ::munmap( sqes_, params_.sq_entries * sizeof( io_uring_sqe ) );
+  if ( cq_ring_ != sq_ring_ ) {
+    ::munmap( cq_ring_, cq_ring_size_ );
+  }
+  ::munmap( sq_ring_, sq_ring_size_ );
+  if ( pool_ ) {
+    ::munmap( pool_, pool_size_ );
+  }
+}
+
+void IOUring::register_buffers( size_t count, size_t size )
+{
+  if ( pool_ ) {
+    throw runtime_error( "IOUring: buffers already registered" );
+  }
+  if ( count == 0 or count > UINT16_MAX ) {
+    throw runtime_error( "IOUring: bad number of buffers" );
+  }
+
+  // Anonymous memory comes zeroed once, here, and never again
+  void* pool = ::mmap( nullptr, count * size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+  if ( pool == MAP_FAILED ) {
+    throw unix_error { "mmap" };
+  }
+  pool_ = static_cast<char*>( pool );
+  pool_size_ = count * size;
+  buffer_size_ = size;
+
+  vector<iovec> iovecs( count );
+  for ( size_t i = 0; i < count; i++ ) {
+    iovecs[i] = { pool_ + i * size, size };
+    free_buffers_.push_back( static_cast<uint16_t>( count - 1 - i ) );
+  }
+  CheckSystemCall(
+    "io_uring_register",
+    io_uring_register( ring_.fd_num(), IORING_REGISTER_BUFFERS, iovecs.data(), static_cast<unsigned>( count ) ) );
+}
+
+int IOUring::acquire_buffer()
+{
+  if ( free_buffers_.empty() ) {
+    return -1;
+  }
+  const uint16_t index = free_buffers_.back();
+  free_buffers_.pop_back();
+  return index;
+}
+
+io_uring_sqe& IOUring::next_sqe()
+{
+  if ( *sq_tail_ - load_acquire( sq_head_ ) == params_.sq_entries ) {
+    submit();
+  }
+  const unsigned index = *sq_tail_ & sq_mask_;
+  io_uring_sqe& sqe = sqes_[index];
+  memset( &sqe, 0, sizeof( sqe ) );
+  sq_array_[index] = index;
+  return sqe;
+}
+
+void IOUring::queue( uint8_t opcode,
+                     int fd,
+                     const void* addr,
+                     size_t len,
+                     uint64_t user_data,
+                     uint16_t buf_index )
+{
+  io_uring_sqe& sqe = next_sqe();
+  sqe.opcode = opcode;
+  sqe.fd = fd;
+  sqe.off = -1ULL; // at (and advancing) the file's current position, as FileDescriptor::read and write do
+  sqe.addr = reinterpret_cast<uint64_t>( addr ); // NOLINT(*-reinterpret-cast)
+  sqe.len = static_cast<uint32_t>( len );
+  sqe.buf_index = buf_index;
+  sqe.user_data = user_data;
+
+  // The whole entry is filled in before the kernel can see it
+  store_release( sq_tail_, *sq_tail_ + 1 );
+  queued_++;
+}
+
+void IOUring::read( const FileDescriptor& fd, span<char> buffer, uint64_t user_data )
+{
+  queue( IORING_OP_READ, fd.fd_num(), buffer.data(), buffer.size(), user_data );
+}
+
+void IOUring::write( const FileDescriptor& fd, string_view buffer, uint64_t user_data )
+{
+  queue( IORING_OP_WRITE, fd.fd_num(), buffer.data(), buffer.size(), user_data );
+}
+
+void IOUring::writev( const FileDescriptor& fd, span<const iovec> iovecs, uint64_t user_data )
+{
+  queue( IORING_OP_WRITEV, fd.fd_num(), iovecs.data(), iovecs.size(), user_data );
+}
+
+void IOUring::read_fixed( const FileDescriptor& fd, uint16_t index, size_t len, uint64_t user_data )
+{
+  queue( IORING_OP_READ_FIXED, fd.fd_num(), buffer( index ).data(), min( len, buffer_size_ ), user_data, index );
+}
+
+void IOUring::write_fixed( const FileDescriptor& fd, uint16_t index, size_t len, uint64_t user_data )
+{
+  queue( IORING_OP_WRITE_FIXED, fd.fd_num(), buffer( index ).data(), min( len, buffer_size_ ), user_data, index );
+}
+
+void IOUring::submit( unsigned wait_for )
+{
+  while ( queued_ > 0 or wait_for > 0 ) {
+    const int submitted = io_uring_enter(
+      ring_.fd_num(), queued_, wait_for, wait_for > 0 ? static_cast<unsigned>( IORING_ENTER_GETEVENTS ) : 0 );
+    if ( submitted < 0 ) {
+      if ( errno == EINTR ) {
+        continue;
+      }
+      throw unix_error { "io_uring_enter" };
+    }
+    queued_ -= static_cast<unsigned>( submitted );
+    wait_for = 0;
+    if ( submitted == 0 ) {
+      break;
+    }
+  }
+}
+
+size_t IOUring::reap( vector<Completion>& out )
+{
+  unsigned head = *cq_head_;
+  const unsigned tail = load_acquire( cq_tail_ );
+  const size_t n = tail - head;
+  for ( ; head != tail; head++ ) {
+    const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+    out.push_back( { cqe.user_data, cqe.res } );
+  }
+  store_release( cq_head_, head );
+  return n;
+}
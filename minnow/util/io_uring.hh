@@ -0,0 +1,91 @@
+#pragma once
+
+#include "file_descriptor.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <linux/io_uring.h>
+#include <span>
+#include <string_view>
+#include <sys/uio.h>
+#include <vector>
+
+// An io_uring instance: reads and writes are queued without any system call, and a whole batch of them is
+// submitted (and, optionally, waited for) with a single io_uring_enter().
+//
+// The ring can also own a pool of fixed-size buffers registered with the kernel. Those stay pinned, so
+// read_fixed() and write_fixed() skip the per-call page lookups, and a read lands in memory that is reused
+// as is rather than allocated and zero-filled each time (as FileDescriptor::read does).
+//
+// Talks to the kernel through the raw system calls, so it needs no liburing.
+class IOUring
+{
+public:
+  struct Completion
+  {
+    uint64_t user_data; // as given when the operation was queued
+    int32_t result;     // bytes transferred, or -errno
+  };
+
+private:
+  io_uring_params params_ {}; // filled in by io_uring_setup() while ring_ is constructed
+  FileDescriptor ring_;
+
+  // The shared ring memory
+  void* sq_ring_ {};
+  size_t sq_ring_size_ {};
+  void* cq_ring_ {};
+  size_t cq_ring_size_ {};
+  io_uring_sqe* sqes_ {};
+
+  unsigned* sq_tail_ {};
+  const unsigned* sq_head_ {};
+  unsigned sq_mask_ {};
+  unsigned* sq_array_ {};
+  unsigned* cq_head_ {};
+  const unsigned* cq_tail_ {};
+  unsigned cq_mask_ {};
+  const io_uring_cqe* cqes_ {};
+  unsigned queued_ {}; // SQEs queued since the last submit()
+
+  // The registered buffers, one allocation cut into equal slots
+  char* pool_ {};
+  size_t pool_size_ {};
+  size_t buffer_size_ {};
+  std::vector<uint16_t> free_buffers_ {};
+
+  io_uring_sqe& next_sqe();
+  void queue( uint8_t opcode, int fd, const void* addr, size_t len, uint64_t user_data, uint16_t buf_index = 0 );
+
+public:
+  // A ring with room for `entries` queued operations (rounded up to a power of two)
+  explicit IOUring( unsigned entries = 256 );
+  ~IOUring();
+
+  IOUring( const IOUring& other ) = delete;
+  IOUring& operator=( const IOUring& other ) = delete;
+
+  // Allocate `count` buffers of `size` bytes and register them with the kernel (once per ring)
+  void register_buffers( size_t count, size_t size );
+
+  // Take a registered buffer for an operation, and give it back afterwards. Returns -1 if none is free.
+  int acquire_buffer();
+  void release_buffer( uint16_t index ) { free_buffers_.push_back( index ); }
+  std::span<char> buffer( uint16_t index ) const { return { pool_ + index * buffer_size_, buffer_size_ }; }
+  size_t buffer_size() const { return buffer_size_; }
+
+  // Queue an operation (submitting what is already queued first, if the ring is full). The memory involved
+  // must stay valid until the operation completes. Like FileDescriptor's, reads and writes are at the file's
+  // current position, which each one advances.
+  void read( const FileDescriptor& fd, std::span<char> buffer, uint64_t user_data );
+  void write( const FileDescriptor& fd, std::string_view buffer, uint64_t user_data );
+  void writev( const FileDescriptor& fd, std::span<const iovec> iovecs, uint64_t user_data );
+  void read_fixed( const FileDescriptor& fd, uint16_t index, size_t len, uint64_t user_data );
+  void write_fixed( const FileDescriptor& fd, uint16_t index, size_t len, uint64_t user_data );
+
+  // Submit everything queued, and wait until at least `wait_for` operations have completed
+  void submit( unsigned wait_for = 0 );
+
+  // Take the completions that are available (without waiting); returns how many were added to `out`
+  size_t reap( std::vector<Completion>& out );
+};
@@ -1,17 +1,17 @@
 #pragma once
 
+#include "buffer_chain.hh"
 #include "ipv4_header.hh"
 #include "parser.hh"
 
 #include <memory>
 #include <string>
-#include <vector>
 
 //! \brief [IPv4](\ref rfc::rfc791) Internet datagram
 struct IPv4Datagram
 {
   IPv4Header header {};
-  std::vector<Buffer> payload {};
+  BufferChain payload {};
 
   void parse( Parser& parser )
   {
@@ -22,9 +22,7 @@ struct IPv4Datagram
   void serialize( Serializer& serializer ) const
   {
     header.serialize( serializer );
-    for ( const auto& x : payload ) {
-      serializer.buffer( x );
-    }
+    serializer.buffer( payload );
   }
 };
 
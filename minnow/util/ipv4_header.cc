@@ -1,5 +1,6 @@
 #include "ipv4_header.hh"
 #include "checksum.hh"
+#include "header_layout.hh"
 
 #include <arpa/inet.h>
 #include <array>
@@ -8,28 +9,35 @@
 
 using namespace std;
 
+namespace {
+
+using Layout = HeaderLayout<Field<&IPv4Header::ver, 4>,
+                            Field<&IPv4Header::hlen, 4>,
+                            Field<&IPv4Header::tos, 8>,
+                            Field<&IPv4Header::len, 16>,
+                            Field<&IPv4Header::id, 16>,
+                            Reserved<1>,
+                            Field<&IPv4Header::df, 1>,
+                            Field<&IPv4Header::mf, 1>,
+                            Field<&IPv4Header::offset, 13>,
+                            Field<&IPv4Header::ttl, 8>,
+                            Field<&IPv4Header::proto, 8>,
+                            Field<&IPv4Header::cksum, 16>,
+                            Field<&IPv4Header::src, 32>,
+                            Field<&IPv4Header::dst, 32>>;
+static_assert( Layout::LENGTH == IPv4Header::LENGTH );
+
+} // namespace
+
 // Parse from string.
 void IPv4Header::parse( Parser& parser )
 {
-  uint8_t first_byte {};
-  parser.integer( first_byte );
-  ver = first_byte >> 4;    // version
-  hlen = first_byte & 0x0f; // header length
-  parser.integer( tos );    // type of service
-  parser.integer( len );
-  parser.integer( id );
-
-  uint16_t fo_val {};
-  parser.integer( fo_val );
-  df = static_cast<bool>( fo_val & 0x4000 ); // don't fragment
-  mf = static_cast<bool>( fo_val & 0x2000 ); // more fragments
-  offset = fo_val & 0x1fff;                  // offset
-
-  parser.integer( ttl );
-  parser.integer( proto );
-  parser.integer( cksum );
-  parser.integer( src );
-  parser.integer( dst );
+  array<char, LENGTH> scratch {};
+  const string_view raw = parser.contiguous( scratch );
+  if ( parser.has_error() ) {
+    return;
+  }
+  Layout::decode( *this, raw );
 
   if ( ver != 4 ) {
     parser.set_error();
@@ -41,10 +49,10 @@ void IPv4Header::parse( Parser& parser )
 
   parser.remove_prefix( static_cast<uint64_t>( hlen ) * 4 - IPv4Header::LENGTH );
 
-  // Verify checksum
-  const uint16_t given_cksum = cksum;
-  compute_checksum();
-  if ( cksum != given_cksum ) {
+  // Verify checksum: the sum over the header, checksum field included, must be all ones
+  InternetChecksum check;
+  check.add( raw );
+  if ( check.value() != 0 ) {
     parser.set_error();
   }
 }
@@ -57,22 +65,7 @@ void IPv4Header::serialize( Serializer& serializer ) const
     throw runtime_error( "wrong IP version" );
   }
 
-  const uint8_t first_byte = ( static_cast<uint32_t>( ver ) << 4 ) | ( hlen & 0xfU );
-  serializer.integer( first_byte ); // version and header length
-  serializer.integer( tos );
-  serializer.integer( len );
-  serializer.integer( id );
-
-  const uint16_t fo_val = ( df ? 0x4000U : 0 ) | ( mf ? 0x2000U : 0 ) | ( offset & 0x1fffU );
-  serializer.integer( fo_val );
-
-  serializer.integer( ttl );
-  serializer.integer( proto );
-
-  serializer.integer( cksum );
-
-  serializer.integer( src );
-  serializer.integer( dst );
+  Layout::serialize( *this, serializer );
 }
 
 uint16_t IPv4Header::payload_length() const
@@ -103,12 +96,12 @@ uint32_t IPv4Header::pseudo_checksum() const
 void IPv4Header::compute_checksum()
 {
   cksum = 0;
-  Serializer s;
-  serialize( s );
+  array<char, LENGTH> header {};
+  Layout::encode( *this, header.data() );
 
   // calculate checksum -- taken over header only
   InternetChecksum check;
-  check.add( s.output() );
+  check.add( { header.data(), header.size() } );
   cksum = check.value();
 }
 
@@ -1,100 +1,129 @@
 #pragma once
 
 #include "buffer.hh"
+#include "buffer_chain.hh"
+#include "checksum.hh"
 
 #include <algorithm>
 #include <concepts>
 #include <cstdint>
 #include <cstring>
-#include <deque>
+#include <endian.h>
 #include <numeric>
 #include <span>
 #include <stdexcept>
 #include <string>
 #include <string_view>
-#include <vector>
 
 class Serializer;
 
+// Convert an integer between host and network (big-endian) byte order (the conversion is its own inverse)
+template<std::unsigned_integral T>
+T network_order( T x )
+{
+  if constexpr ( sizeof( T ) == 1 ) {
+    return x;
+  } else if constexpr ( sizeof( T ) == 2 ) {
+    return htobe16( x );
+  } else if constexpr ( sizeof( T ) == 4 ) {
+    return htobe32( x );
+  } else {
+    return htobe64( x );
+  }
+}
+
 class Parser
 {
   class BufferList
   {
     uint64_t size_ {};
-    std::deque<Buffer> buffer_ {};
-    uint64_t skip_ {};
+    BufferChain buffer_ {};     // holds a few buffers without allocating
+    size_t head_ {};            // index of the buffer being read
+    std::string_view front_ {}; // unread part of buffer_[head_], or of the whole input when given as a view
+
+    void append( Buffer str )
+    {
+      if ( str.empty() ) {
+        return;
+      }
+      size_ += str.size();
+      buffer_.push_back( std::move( str ) );
+      if ( buffer_.size() == 1 ) {
+        front_ = buffer_.front();
+      }
+    }
 
   public:
     // NOLINTNEXTLINE(*-explicit-*)
-    BufferList( const std::vector<Buffer>& buffers )
+    BufferList( std::span<const Buffer> buffers )
     {
       for ( const auto& x : buffers ) {
         append( x );
       }
     }
 
+    explicit BufferList( std::string_view view ) : size_( view.size() ), front_( view ) {}
+
     uint64_t size() const { return size_; }
     uint64_t serialized_length() const { return size(); }
     bool empty() const { return size_ == 0; }
 
     std::string_view peek() const
     {
-      if ( buffer_.empty() ) {
+      if ( empty() ) {
         throw std::runtime_error( "peek on empty BufferList" );
       }
-      return std::string_view { buffer_.front() }.substr( skip_ );
+      return front_;
     }
 
-    void remove_prefix( uint64_t len )
+    // Remove `len` bytes, all of which are in the front buffer
+    void remove_front( uint64_t len )
     {
-      while ( len and not buffer_.empty() ) {
-        const uint64_t to_pop_now = std::min( len, peek().size() );
-        skip_ += to_pop_now;
-        len -= to_pop_now;
-        size_ -= to_pop_now;
-        if ( skip_ == buffer_.front().size() ) {
-          buffer_.pop_front();
-          skip_ = 0;
-        }
+      front_.remove_prefix( len );
+      size_ -= len;
+      if ( front_.empty() and head_ < buffer_.size() ) {
+        head_++;
+        front_ = head_ < buffer_.size() ? std::string_view { buffer_[head_] } : std::string_view {};
       }
     }
 
-    void dump_all( std::vector<Buffer>& out )
+    void remove_prefix( uint64_t len )
     {
-      out.clear();
-      if ( empty() ) {
-        return;
-      }
-      std::string first_str = std::move( buffer_.front() );
-      if ( skip_ ) {
-        first_str = first_str.substr( skip_ );
-      }
-      out.emplace_back( std::move( first_str ) );
-      buffer_.pop_front();
-      for ( auto&& x : buffer_ ) {
-        out.emplace_back( std::move( x ) );
+      while ( len and not empty() ) {
+        const uint64_t to_pop_now = std::min( len, static_cast<uint64_t>( front_.size() ) );
+        remove_front( to_pop_now );
+        len -= to_pop_now;
       }
     }
 
-    void dump_all( Buffer& out )
+    void dump_all( BufferChain& out )
     {
-      std::vector<Buffer> concat;
-      dump_all( concat );
-      if ( concat.size() == 1 ) {
-        out = concat.front();
+      out.clear();
+      if ( empty() ) {
         return;
       }
 
-      out.release().clear();
-      for ( const auto& s : concat ) {
-        out.release().append( s );
+      // The rest is shared with the input, not copied (except when parsing a string_view)
+      if ( buffer_.empty() ) {
+        out.push_back( Buffer::copy_of( front_ ) );
+      } else {
+        const Buffer& first = buffer_[head_];
+        out.push_back( first.slice( front_.data() - first.data() ) );
+        for ( size_t next = head_ + 1; next < buffer_.size(); next++ ) {
+          out.push_back( buffer_[next] );
+        }
       }
+      buffer_.clear();
+      head_ = 0;
+      front_ = {};
+      size_ = 0;
     }
 
-    void append( Buffer str )
+    void dump_all( Buffer& out )
     {
-      size_ += str.size();
-      buffer_.push_back( std::move( str ) );
+      BufferChain chain;
+      dump_all( chain );
+      out = chain.size() == 1 ? chain.front() : Buffer { chain.concatenate() };
     }
   };
 
@@ -109,7 +138,10 @@ class Parser
   }
 
 public:
-  explicit Parser( const std::vector<Buffer>& input ) : input_( input ) {}
+  explicit Parser( std::span<const Buffer> input ) : input_( input ) {}
+
+  // Parse a single contiguous buffer, which must outlive the Parser
+  explicit Parser( std::string_view input ) : input_( input ) {}
 
   const BufferList& input() const { return input_; }
 
@@ -125,11 +157,15 @@ public:
       return;
     }
 
-    if constexpr ( sizeof( T ) == 1 ) {
-      out = static_cast<uint8_t>( input_.peek().front() );
-      input_.remove_prefix( 1 );
-      return;
+    // Fast path: the whole integer is in the front buffer, so load it in one go
+    const std::string_view front = input_.peek();
+    if ( front.size() >= sizeof( T ) ) {
+      T raw;
+      std::memcpy( &raw, front.data(), sizeof( T ) );
+      out = network_order( raw );
+      input_.remove_front( sizeof( T ) );
     } else {
+      // The integer straddles two buffers
       out = static_cast<T>( 0 );
       for ( size_t i = 0; i < sizeof( T ); i++ ) {
         out <<= 8;
@@ -139,6 +175,24 @@ public:
     }
   }
 
+  // The next `scratch.size()` bytes as one view: straight from the front buffer if they are all there,
+  // otherwise copied into `scratch`. Empty, with the error flag set, if the input is too short.
+  std::string_view contiguous( std::span<char> scratch )
+  {
+    check_size( scratch.size() );
+    if ( has_error() or scratch.empty() ) {
+      return {};
+    }
+
+    const std::string_view front = input_.peek().substr( 0, scratch.size() );
+    if ( front.size() == scratch.size() ) {
+      input_.remove_front( scratch.size() );
+      return front;
+    }
+    string( scratch );
+    return { scratch.data(), scratch.size() };
+  }
+
   void string( std::span<char> out )
   {
     check_size( out.size() );
@@ -154,28 +208,47 @@ public:
     }
   }
 
-  void all_remaining( std::vector<Buffer>& out ) { input_.dump_all( out ); }
+  void all_remaining( BufferChain& out ) { input_.dump_all( out ); }
   void all_remaining( Buffer& out ) { input_.dump_all( out ); }
 };
 
 class Serializer
 {
-  std::vector<Buffer> output_ {};
+  BufferChain output_ {};
   std::string buffer_ {};
+  std::span<char> headroom_ {}; // caller-provided region that headers are written into, if any
+  size_t used_ {};              // bytes of headroom_ written so far
+  size_t flushed_ {};           // bytes of headroom_ already copied to output_
 
 public:
+  // Where to write the next `len` bytes (for callers that encode them in place)
+  char* room( size_t len )
+  {
+    if ( headroom_.empty() ) {
+      buffer_.resize( buffer_.size() + len );
+      return buffer_.data() + buffer_.size() - len;
+    }
+
+    if ( len > headroom_.size() - used_ ) {
+      throw std::runtime_error( "Serializer headroom exhausted" );
+    }
+    used_ += len;
+    return headroom_.data() + used_ - len;
+  }
+
   Serializer() = default;
   explicit Serializer( std::string&& buffer ) : buffer_( std::move( buffer ) ) {}
 
+  // Write into `headroom` (e.g. a std::array on the stack, sized with the headers' LENGTH constants)
+  // rather than onto the heap. The bytes written are available from headroom() without any allocation;
+  // only a call to output() copies them into a Buffer.
+  explicit Serializer( std::span<char> headroom ) : headroom_( headroom ) {}
+
   template<std::unsigned_integral T>
   void integer( const T& val )
   {
-    constexpr uint64_t len = sizeof( T );
-
-    for ( uint64_t i = 0; i < len; ++i ) {
-      const uint8_t byte_val = val >> ( ( len - i - 1 ) * 8 );
-      buffer_.push_back( byte_val );
-    }
+    const T raw = network_order( val );
+    std::memcpy( room( sizeof( T ) ), &raw, sizeof( T ) );
   }
 
   void buffer( const Buffer& buf )
@@ -184,29 +257,60 @@ public:
     output_.push_back( buf );
   }
 
-  void buffer( const std::vector<Buffer>& bufs )
+  // Headers written to the headroom just before a payload handed over this way go into the payload's own
+  // headroom when it has enough, instead of into a Buffer of their own
+  void buffer( Buffer&& buf )
   {
+    if ( used_ > flushed_ and buffer_.empty()
+         and buf.prepend( { headroom_.data() + flushed_, used_ - flushed_ } ) ) {
+      flushed_ = used_;
+    }
+    flush();
+    output_.push_back( std::move( buf ) );
+  }
+
+  void buffer( std::span<const Buffer> bufs )
+  {
+    output_.reserve( output_.size() + bufs.size() + 2 ); // room for the pending headroom and buffer_ too
+    flush();
     for ( const auto& b : bufs ) {
-      buffer( b );
+      output_.push_back( b );
     }
   }
 
+  // Copy `data` into the output (rather than sharing it, as buffer() does), adding it to `checksum`
+  // in the same pass. Worth it for small payloads, which would otherwise cost a Buffer of their own.
+  void buffer( std::string_view data, InternetChecksum& checksum )
+  {
+    checksum.add_copy( room( data.size() ), data );
+  }
+
+  // The bytes written into the headroom so far
+  std::string_view headroom() const { return { headroom_.data(), used_ }; }
+
   void flush()
   {
-    output_.emplace_back( std::move( buffer_ ) );
-    buffer_.clear();
+    if ( used_ > flushed_ ) {
+      output_.push_back( Buffer::copy_of( { headroom_.data() + flushed_, used_ - flushed_ } ) );
+      flushed_ = used_;
+    }
+    if ( not buffer_.empty() ) {
+      output_.emplace_back( std::move( buffer_ ) );
+      buffer_.clear();
+    }
   }
 
-  std::vector<Buffer> output()
+  // Takes everything serialized so far
+  BufferChain output()
   {
     flush();
-    return output_;
+    return std::move( output_ );
   }
 };
 
 // Helper to serialize any object (without constructing a Serializer of the caller's own)
 template<class T>
-std::vector<Buffer> serialize( const T& obj )
+BufferChain serialize( const T& obj )
 {
   Serializer s;
   obj.serialize( s );
@@ -215,9 +319,17 @@ std::vector<Buffer> serialize( const T& obj )
 
 // Helper to parse any object (without constructing a Parser of the caller's own). Returns true if successful.
 template<class T>
-bool parse( T& obj, const std::vector<Buffer>& buffers )
+bool parse( T& obj, std::span<const Buffer> buffers )
 {
   Parser p { buffers };
   obj.parse( p );
   return not p.has_error();
 }
+
+template<class T>
+bool parse( T& obj, std::string_view buffer )
+{
+  Parser p { buffer };
+  obj.parse( p );
+  return not p.has_error();
+}
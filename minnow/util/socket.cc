@@ -3,8 +3,10 @@
 #include "exception.hh"
 
 #include <cstddef>
+#include <cstring>
 #include <linux/if_packet.h>
 #include <net/if.h>
+#include <netinet/udp.h>
 #include <stdexcept>
 #include <sys/ioctl.h>
 #include <unistd.h>
@@ -115,16 +117,19 @@ void Socket::shutdown( const int how )
   }
 }
 
-//! \note If payload is too small to hold the received datagram, this method throws a std::runtime_error
 void DatagramSocket::recv( Address& source_address, string& payload )
+{
+  const span<char> scratch = read_scratch();
+  payload.assign( scratch.data(), recv( source_address, scratch ) );
+}
+
+//! \note If payload is too small to hold the received datagram, this method throws a std::runtime_error
+size_t DatagramSocket::recv( Address& source_address, span<char> payload )
 {
   // receive source address and payload
   Address::Raw datagram_source_address;
   socklen_t fromlen = sizeof( datagram_source_address );
 
-  payload.clear();
-  payload.resize( kReadBufferSize );
-
   const ssize_t recv_len = CheckSystemCall(
     "recvfrom",
     ::recvfrom( fd_num(), payload.data(), payload.size(), MSG_TRUNC, datagram_source_address, &fromlen ) );
@@ -135,7 +140,7 @@ void DatagramSocket::recv( Address& source_address, string& payload )
 
   register_read();
   source_address = { datagram_source_address, fromlen };
-  payload.resize( recv_len );
+  return recv_len;
 }
 
 void DatagramSocket::sendto( const Address& destination, const string_view payload )
@@ -151,6 +156,205 @@ void DatagramSocket::send( const string_view payload )
   register_write();
 }
 
+bool DatagramSocket::send( const BufferChain& payload )
+{
+  const span<const iovec> iovecs = payload.iovecs();
+  const ssize_t n = ::writev( fd_num(), iovecs.data(), static_cast<int>( iovecs.size() ) );
+  if ( n < 0 and errno == EAGAIN ) {
+    return false;
+  }
+  CheckSystemCall( "writev", static_cast<int>( n ) );
+  register_write();
+  return true;
+}
+
+DatagramBatch::DatagramBatch( size_t max_datagrams, size_t slot_size )
+  : slot_size_( slot_size )
+  , slots_( max_datagrams )
+  , payloads_( max_datagrams )
+  , addresses_( max_datagrams )
+  , iovecs_( max_datagrams )
+  , headers_( max_datagrams )
+  , controls_( max_datagrams )
+  , segment_sizes_( max_datagrams )
+{
+  if ( max_datagrams == 0 ) {
+    throw runtime_error( "DatagramBatch: capacity must be positive" );
+  }
+}
+
+Address DatagramBatch::address( size_t i ) const
+{
+  if ( i >= size_ ) {
+    throw out_of_range( "DatagramBatch::address" );
+  }
+  return { addresses_[i], headers_[i].msg_hdr.msg_namelen };
+}
+
+void DatagramBatch::push_back( const Address& destination, Buffer payload )
+{
+  if ( full() ) {
+    throw runtime_error( "DatagramBatch is full" );
+  }
+  memcpy( &addresses_[size_].storage, static_cast<const sockaddr*>( destination ), destination.size() );
+  payloads_[size_] = move( payload );
+  iovecs_[size_] = { const_cast<char*>( payloads_[size_].data() ), payloads_[size_].size() }; // NOLINT
+  headers_[size_] = { { addresses_[size_], destination.size(), &iovecs_[size_], 1, nullptr, 0, 0 }, 0 };
+  segment_sizes_[size_] = payloads_[size_].size();
+  size_++;
+}
+
+void DatagramBatch::clear()
+{
+  for ( size_t i = 0; i < size_; i++ ) {
+    payloads_[i] = {};
+  }
+  size_ = 0;
+}
+
+size_t DatagramSocket::recv_batch( DatagramBatch& batch )
+{
+  batch.clear();
+  batch.n_truncated_ = 0;
+
+  // A batch of nothing but oversized datagrams is dropped, and the next one taken in its place
+  while ( batch.empty() ) {
+    // Point each header at its slot, replacing any slot whose last payload is still in use elsewhere
+    for ( size_t i = 0; i < batch.capacity(); i++ ) {
+      Buffer& slot = batch.slots_[i];
+      if ( not slot.unique() ) {
+        slot = Buffer::uninitialized( batch.slot_size_ );
+      }
+      batch.iovecs_[i] = { slot.mutable_data(), slot.size() };
+      batch.headers_[i] = { { batch.addresses_[i],
+                              sizeof( batch.addresses_[i].storage ),
+                              &batch.iovecs_[i],
+                              1,
+                              batch.controls_[i].bytes.data(),
+                              batch.controls_[i].bytes.size(),
+                              0 },
+                            0 };
+    }
+
+    const int received = ::recvmmsg(
+      fd_num(), batch.headers_.data(), static_cast<unsigned>( batch.capacity() ), MSG_WAITFORONE, nullptr );
+    if ( received < 0 and errno == EAGAIN ) {
+      return 0;
+    }
+    CheckSystemCall( "recvmmsg", received );
+
+    for ( size_t i = 0; i < static_cast<size_t>( received ); i++ ) {
+      msghdr& header = batch.headers_[i].msg_hdr;
+      register_read();
+
+      // The kernel has already taken a datagram too large for its slot off the socket, along with the rest
+      // of the batch; it is dropped (and counted), and the others kept, in order
+      if ( header.msg_flags & MSG_TRUNC ) {
+        batch.n_truncated_++;
+        continue;
+      }
+
+      const size_t kept = batch.size_++;
+      batch.payloads_[kept] = batch.slots_[i].slice( 0, batch.headers_[i].msg_len );
+      batch.segment_sizes_[kept] = batch.headers_[i].msg_len;
+      for ( cmsghdr* control = CMSG_FIRSTHDR( &header ); control; control = CMSG_NXTHDR( &header, control ) ) {
+        if ( control->cmsg_level == SOL_UDP and control->cmsg_type == UDP_GRO ) {
+          int segment_size {};
+          memcpy( &segment_size, CMSG_DATA( control ), sizeof( segment_size ) );
+          batch.segment_sizes_[kept] = segment_size;
+        }
+      }
+      if ( kept != i ) {
+        batch.addresses_[kept] = batch.addresses_[i];
+        batch.headers_[kept].msg_hdr.msg_namelen = header.msg_namelen;
+      }
+    }
+  }
+  return batch.size_;
+}
+
+size_t DatagramSocket::send_batch( const DatagramBatch& batch )
+{
+  size_t sent = 0;
+  while ( sent < batch.size() ) {
+    const int n
+      = ::sendmmsg( fd_num(), batch.headers_.data() + sent, static_cast<unsigned>( batch.size() - sent ), 0 );
+    if ( n < 0 and errno == EAGAIN ) {
+      break;
+    }
+    sent += CheckSystemCall( "sendmmsg", n );
+    for ( int i = 0; i < n; i++ ) {
+      register_write();
+    }
+  }
+  return sent;
+}
+
+size_t UDPSocket::send_segments( const Address& destination, span<const Buffer> segments )
+{
+  size_t sent = 0;
+  array<iovec, MAX_GSO_SEGMENTS> iovecs {};
+  struct
+  {
+    alignas( cmsghdr ) array<char, CMSG_SPACE( sizeof( uint16_t ) )> bytes;
+  } control {};
+
+  while ( not segments.empty() ) {
+    // Take the longest run of segments the size of the first, plus one shorter one if it comes next (but not an
+    // empty one, which the kernel would not cut out of the run as a datagram of its own)
+    const size_t segment_size = segments.front().size();
+    size_t count = 0;
+    size_t total = 0;
+    while ( count < segments.size() and count < MAX_GSO_SEGMENTS ) {
+      const Buffer& segment = segments[count];
+      if ( count > 0
+           and ( segment.size() > segment_size or segment.size() == 0 or total + segment.size() > MAX_GSO_SIZE ) ) {
+        break;
+      }
+      iovecs[count] = { const_cast<char*>( segment.data() ), segment.size() }; // NOLINT(*-const-cast)
+      total += segment.size();
+      count++;
+      if ( segment.size() < segment_size or segment_size == 0 ) {
+        break;
+      }
+    }
+
+    msghdr header {};
+    header.msg_name = const_cast<sockaddr*>( static_cast<const sockaddr*>( destination ) ); // NOLINT
+    header.msg_namelen = destination.size();
+    header.msg_iov = iovecs.data();
+    header.msg_iovlen = count;
+
+    // A lone datagram needs no segmenting
+    if ( count > 1 ) {
+      header.msg_control = control.bytes.data();
+      header.msg_controllen = control.bytes.size();
+      cmsghdr* gso = CMSG_FIRSTHDR( &header );
+      gso->cmsg_level = SOL_UDP;
+      gso->cmsg_type = UDP_SEGMENT;
+      gso->cmsg_len = CMSG_LEN( sizeof( uint16_t ) );
+      const auto gso_size = static_cast<uint16_t>( segment_size );
+      memcpy( CMSG_DATA( gso ), &gso_size, sizeof( gso_size ) );
+    }
+
+    // A run goes out whole or not at all
+    const ssize_t n = ::sendmsg( fd_num(), &header, 0 );
+    if ( n < 0 and errno == EAGAIN ) {
+      break;
+    }
+    CheckSystemCall( "sendmsg", n );
+    register_write();
+    segments = segments.subspan( count );
+    sent += count;
+  }
+  return sent;
+}
+
+void UDPSocket::set_gro( bool enabled )
+{
+  setsockopt( SOL_UDP, UDP_GRO, int { enabled } );
+}
+
 // mark the socket as listening for incoming connections
 //! \param[in] backlog is the number of waiting connections to queue (see [listen(2)](\ref man2::listen))
 void TCPSocket::listen( const int backlog )
@@ -1,11 +1,17 @@
 #pragma once
 
 #include "address.hh"
+#include "buffer.hh"
 #include "file_descriptor.hh"
 
+#include <array>
 #include <cstdint>
 #include <functional>
+#include <netinet/in.h>
+#include <span>
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <vector>
 
 //! \brief Base class for network sockets (TCP, UDP, etc.)
 //! \details Socket is generally used via a subclass. See TCPSocket and UDPSocket for usage examples.
@@ -58,19 +64,95 @@ public:
   void throw_if_error() const;
 };
 
+//! \brief Datagrams and their addresses, for moving many at once with DatagramSocket::recv_batch() and
+//! send_batch()
+//! \details The batch keeps its message headers and receive buffers from one call to the next. A received
+//! payload shares its slot's pooled Buffer, which is reused by the next recv_batch() unless the payload is
+//! still held elsewhere.
+class DatagramBatch
+{
+  friend class DatagramSocket;
+
+  size_t slot_size_;                       // largest datagram recv_batch() accepts
+  std::vector<Buffer> slots_;              // receive storage, slot_size_ bytes each
+  std::vector<Buffer> payloads_;           // the datagrams in the batch
+  std::vector<Address::Raw> addresses_;    // their sources or destinations
+  std::vector<iovec> iovecs_;              // one per datagram
+  mutable std::vector<mmsghdr> headers_;   // one per datagram, pointing into the above (sendmmsg() sets msg_len)
+  size_t size_ {};
+  size_t n_truncated_ {};                  // oversized datagrams dropped by the last recv_batch()
+
+  // Room for the UDP_GRO control message that comes with a coalesced datagram
+  struct Control
+  {
+    alignas( cmsghdr ) std::array<char, CMSG_SPACE( sizeof( int ) )> bytes;
+  };
+  std::vector<Control> controls_;
+  std::vector<size_t> segment_sizes_;
+
+public:
+  //! Room for `max_datagrams` datagrams of up to `slot_size` bytes each (when received)
+  explicit DatagramBatch( size_t max_datagrams, size_t slot_size = Buffer::POOLED_CAPACITY );
+
+  DatagramBatch( const DatagramBatch& other ) = delete;
+  DatagramBatch& operator=( const DatagramBatch& other ) = delete;
+
+  size_t capacity() const { return headers_.size(); }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  bool full() const { return size_ == capacity(); }
+
+  //! The `i`th datagram and the address it came from (or is going to)
+  const Buffer& payload( size_t i ) const { return payloads_.at( i ); }
+  Address address( size_t i ) const;
+
+  //! \brief Size of the datagrams the kernel coalesced into the `i`th payload (see UDPSocket::set_gro())
+  //! \details The payload holds consecutive datagrams of this size, apart from a possibly shorter last one;
+  //! slice() it to take them apart. Equal to the payload's size if it is a single datagram.
+  size_t segment_size( size_t i ) const { return segment_sizes_.at( i ); }
+
+  //! Datagrams the last recv_batch() dropped for being larger than a slot
+  size_t truncated() const { return n_truncated_; }
+
+  //! Queue a datagram for send_batch()
+  void push_back( const Address& destination, Buffer payload );
+
+  //! Empty the batch (its storage is kept)
+  void clear();
+};
+
 class DatagramSocket : public Socket
 {
   using Socket::Socket;
 
 public:
+  //! \brief Receive up to `batch.capacity()` datagrams with one [recvmmsg(2)](\ref man2::recvmmsg)
+  //! \details Waits (on a blocking socket) for the first datagram only, then takes whatever else is queued.
+  //! Replaces the contents of `batch`; returns how many datagrams it now holds (0 if a non-blocking socket
+  //! had none). A datagram larger than the batch's slots is dropped and counted in `batch.truncated()`, and
+  //! the rest of the batch returned.
+  size_t recv_batch( DatagramBatch& batch );
+
+  //! \brief Send the datagrams in `batch` with [sendmmsg(2)](\ref man2::sendmmsg)
+  //! \details Returns how many were sent: all of them, unless a non-blocking socket's buffer filled up.
+  //! The batch is left as it was.
+  size_t send_batch( const DatagramBatch& batch );
+
   //! Receive a datagram and the Address of its sender
   void recv( Address& source_address, std::string& payload );
 
+  //! Receive a datagram into caller-provided storage; returns its length
+  size_t recv( Address& source_address, std::span<char> payload );
+
   //! Send a datagram to specified Address
   void sendto( const Address& destination, std::string_view payload );
 
   //! Send datagram to the socket's connected address (must call connect() first)
   void send( std::string_view payload );
+
+  //! \brief Send a datagram gathered from the Buffers of `payload` to the connected address
+  //! \details Returns false, having sent nothing, if a non-blocking socket's buffer is full.
+  bool send( const BufferChain& payload );
 };
 
 //! A wrapper around [UDP sockets](\ref man7::udp)
@@ -80,8 +162,26 @@ class UDPSocket : public DatagramSocket
   explicit UDPSocket( FileDescriptor&& fd ) : DatagramSocket( std::move( fd ), AF_INET, SOCK_DGRAM ) {}
 
 public:
+  //! Most datagrams the kernel will cut one UDP_SEGMENT send into
+  static constexpr size_t MAX_GSO_SEGMENTS = 64;
+  //! Most bytes one UDP_SEGMENT send (or one UDP_GRO receive) can carry
+  static constexpr size_t MAX_GSO_SIZE = 65507;
+
   //! Default: construct an unbound, unconnected UDP socket
   UDPSocket() : DatagramSocket( AF_INET, SOCK_DGRAM ) {}
+
+  //! \brief Send each of `segments` to `destination` as its own datagram
+  //! \details Runs of equal-size segments (the last of a run may be shorter) go to the kernel as a single
+  //! buffer with [UDP_SEGMENT](\ref man7::udp), and are cut into datagrams below the system call (or, on
+  //! loopback or capable hardware, not until they reach the receiver). Returns how many were sent: all of
+  //! them, unless a non-blocking socket's buffer filled up, when the rest can be sent later from there.
+  size_t send_segments( const Address& destination, std::span<const Buffer> segments );
+
+  //! \brief Let the kernel coalesce consecutive equal-size datagrams from a sender into one payload, with
+  //! [UDP_GRO](\ref man7::udp)
+  //! \details Coalesced payloads can be up to MAX_GSO_SIZE bytes, so the DatagramBatch given to recv_batch()
+  //! needs slots that large; DatagramBatch::segment_size() tells where each payload's datagrams begin.
+  void set_gro( bool enabled );
 };
 
 //! A wrapper around [TCP sockets](\ref man7::tcp)
@@ -90,7 +190,7 @@ class TCPSocket : public Socket
 private:
   //! \brief Construct from FileDescriptor (used by accept())
   //! \param[in] fd is the FileDescriptor from which to construct
-  explicit TCPSocket( FileDescriptor&& fd ) : Socket( std::move( fd ), AF_INET, SOCK_STREAM ) {}
+  explicit TCPSocket( FileDescriptor&& fd ) : Socket( std::move( fd ), AF_INET, SOCK_STREAM, IPPROTO_TCP ) {}
 
 public:
   //! Default: construct an unbound, unconnected TCP socket
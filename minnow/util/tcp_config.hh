@@ -19,4 +19,5 @@ public:
   size_t recv_capacity = DEFAULT_CAPACITY; //!< Receive capacity, in bytes
   size_t send_capacity = DEFAULT_CAPACITY; //!< Sender capacity, in bytes
   std::optional<Wrap32> fixed_isn {};
+  uint64_t idle_compact_ms = 10'000; //!< Compact a connection idle for this long, in milliseconds (0: never)
 };
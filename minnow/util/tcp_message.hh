@@ -0,0 +1,15 @@
+#pragma once
+
+#include "tcp_receiver_message.hh"
+#include "tcp_sender_message.hh"
+
+/*
+ * The TCPMessage structure is what one TCPPeer sends another: a TCPSenderMessage from its sender, with
+ * the acknowledgment and window from its receiver riding along (as they do in a real TCP segment).
+ */
+
+struct TCPMessage
+{
+  TCPSenderMessage sender {};
+  TCPReceiverMessage receiver {};
+};
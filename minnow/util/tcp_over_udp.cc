@@ -0,0 +1,93 @@
+#include "tcp_over_udp.hh"
+#include "random.hh"
+#include "tcp_segment.hh"
+
+#include <array>
+
+using namespace std;
+using namespace std::chrono;
+
+TCPOverUDPAdapter::TCPOverUDPAdapter( UDPSocket&& socket, const Impairments& impairments )
+  : socket_( move( socket ) )
+  , local_port_( socket_.local_address().port() )
+  , peer_port_( socket_.peer_address().port() )
+  , impairments_( impairments )
+  , rng_( get_random_engine() )
+{
+  socket_.set_blocking( false );
+}
+
+void TCPOverUDPAdapter::write( const TCPMessage& message )
+{
+  TCPSegment segment;
+  segment.src_port = local_port_;
+  segment.dst_port = peer_port_;
+  segment.message = message;
+  segment.compute_checksum( 0 );
+
+  // The header is written on the stack and copied into a pooled Buffer; the payload is shared
+  array<char, TCPSegment::LENGTH> headroom {};
+  Serializer serializer { headroom };
+  segment.serialize( serializer );
+  BufferChain datagram = serializer.output();
+
+  if ( impairments_.delay_ms > 0 ) {
+    delayed_.emplace_back( steady_clock::now() + milliseconds { impairments_.delay_ms }, move( datagram ) );
+    send_due();
+    return;
+  }
+  transmit( move( datagram ) );
+}
+
+void TCPOverUDPAdapter::send_due()
+{
+  const auto now = steady_clock::now();
+  while ( not delayed_.empty() and delayed_.front().first <= now ) {
+    transmit( move( delayed_.front().second ) );
+    delayed_.pop_front();
+  }
+}
+
+void TCPOverUDPAdapter::transmit( BufferChain&& segment )
+{
+  if ( impairments_.loss > 0 and coin_( rng_ ) < impairments_.loss ) {
+    return;
+  }
+
+  if ( not held_back_.has_value() and impairments_.reorder > 0 and coin_( rng_ ) < impairments_.reorder ) {
+    held_back_ = move( segment );
+    return;
+  }
+
+  send( segment );
+  if ( held_back_.has_value() ) {
+    send( *held_back_ );
+    held_back_.reset();
+  }
+}
+
+void TCPOverUDPAdapter::send( const BufferChain& segment )
+{
+  if ( not socket_.send( segment ) ) {
+    n_dropped_++;
+  }
+}
+
+optional<TCPMessage> TCPOverUDPAdapter::read()
+{
+  while ( true ) {
+    if ( next_received_ == received_.size() ) {
+      next_received_ = 0;
+      if ( socket_.recv_batch( received_ ) == 0 ) {
+        return nullopt;
+      }
+    }
+
+    TCPSegment segment;
+    Parser parser { span { &received_.payload( next_received_++ ), 1 } };
+    segment.parse( parser, 0 );
+    if ( not parser.has_error() ) {
+      return move( segment.message );
+    }
+  }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "socket.hh"
+#include "tcp_message.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <random>
+#include <utility>
+
+// Ways to mistreat the segments an adapter sends, to see how TCP copes
+struct Impairments
+{
+  double loss = 0;        // probability that a segment is dropped
+  double reorder = 0;     // probability that a segment is held back and sent after the next one
+  uint64_t delay_ms = 0;  // added to every segment's trip
+};
+
+// Carries TCPMessages between two TCPPeers as TCP segments inside UDP datagrams, one segment per datagram.
+//
+// The socket must be connected to the other end's. Segments are read in batches (with recvmmsg), and a
+// received payload shares the Buffer it arrived in. UDP has its own checksum, so the segment checksum is
+// computed without a pseudo-header. A segment the socket has no room for is dropped, and left for TCP to
+// retransmit.
+class TCPOverUDPAdapter
+{
+  UDPSocket socket_;
+  uint16_t local_port_;
+  uint16_t peer_port_;
+
+  DatagramBatch received_ { 64 };
+  size_t next_received_ {}; // the next datagram in received_ to hand out
+
+  Impairments impairments_;
+  std::default_random_engine rng_;
+  std::uniform_real_distribution<double> coin_ { 0, 1 };
+  std::optional<BufferChain> held_back_ {}; // waiting for the next segment to overtake it
+  std::deque<std::pair<std::chrono::steady_clock::time_point, BufferChain>> delayed_ {};
+  size_t n_dropped_ {}; // segments the socket had no room for
+
+  void transmit( BufferChain&& segment );
+  void send( const BufferChain& segment );
+
+public:
+  explicit TCPOverUDPAdapter( UDPSocket&& socket, const Impairments& impairments = {} );
+
+  // For waiting on (e.g. with an EventLoop rule)
+  const UDPSocket& socket() const { return socket_; }
+
+  // Send a message as a TCP segment (subject to the impairments)
+  void write( const TCPMessage& message );
+
+  // The next message that has arrived, if any. Datagrams that are not valid segments are dropped.
+  std::optional<TCPMessage> read();
+
+  // Send the delayed segments whose time has come
+  void send_due();
+
+  // Segments dropped because the socket's send buffer was full (as a congested link would drop them)
+  size_t dropped() const { return n_dropped_; }
+};
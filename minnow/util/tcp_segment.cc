@@ -0,0 +1,181 @@
+#include "tcp_segment.hh"
+#include "checksum.hh"
+#include "header_layout.hh"
+
+#include <array>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+
+using namespace std;
+
+namespace {
+
+// The fixed part of the header, as it sits on the wire
+struct WireHeader
+{
+  uint16_t src_port;
+  uint16_t dst_port;
+  uint32_t seqno;
+  uint32_t ackno;
+  uint8_t data_offset;
+  bool ACK;
+  bool RST;
+  bool SYN;
+  bool FIN;
+  uint16_t window;
+  uint16_t cksum;
+};
+
+using Layout = HeaderLayout<Field<&WireHeader::src_port, 16>,
+                            Field<&WireHeader::dst_port, 16>,
+                            Field<&WireHeader::seqno, 32>,
+                            Field<&WireHeader::ackno, 32>,
+                            Field<&WireHeader::data_offset, 4>,
+                            Reserved<7>, // the reserved bits, CWR, ECE and URG
+                            Field<&WireHeader::ACK, 1>,
+                            Reserved<1>, // PSH
+                            Field<&WireHeader::RST, 1>,
+                            Field<&WireHeader::SYN, 1>,
+                            Field<&WireHeader::FIN, 1>,
+                            Field<&WireHeader::window, 16>,
+                            Field<&WireHeader::cksum, 16>,
+                            Reserved<16>>; // urgent pointer
+static_assert( Layout::LENGTH == TCPSegment::LENGTH );
+
+void encode( const TCPSegment& segment, char* out )
+{
+  const TCPSenderMessage& sender = segment.message.sender;
+  const TCPReceiverMessage& receiver = segment.message.receiver;
+  const WireHeader header { segment.src_port,
+                            segment.dst_port,
+                            sender.seqno.raw_value(),
+                            receiver.ackno.value_or( Wrap32 { 0 } ).raw_value(),
+                            static_cast<uint8_t>( segment.header_length() / 4 ),
+                            receiver.ackno.has_value(),
+                            segment.RST,
+                            sender.SYN,
+                            sender.FIN,
+                            receiver.window_size,
+                            segment.cksum };
+  Layout::encode( header, out );
+}
+
+void check_options( const string& options )
+{
+  if ( options.size() % 4 or options.size() > TCPSegment::MAX_OPTIONS ) {
+    throw runtime_error( "TCP options must be a multiple of four bytes, and at most 40" );
+  }
+}
+
+} // namespace
+
+void TCPSegment::compute_checksum( uint32_t pseudo_checksum )
+{
+  check_options( options );
+
+  // The header is a whole number of words, so the payload's sum can simply be added to the header's
+  const Buffer& payload = message.sender.payload;
+  uint16_t payload_sum = message.sender.payload_sum.value_or( 0 );
+  if ( not message.sender.payload_sum.has_value() ) {
+    InternetChecksum sum;
+    sum.add( payload );
+    payload_sum = sum.sum();
+  }
+
+  cksum = 0;
+  array<char, LENGTH> header {};
+  encode( *this, header.data() );
+
+  InternetChecksum check { pseudo_checksum + payload_sum };
+  check.add( { header.data(), header.size() } );
+  check.add( options );
+  cksum = check.value();
+}
+
+void TCPSegment::parse( Parser& parser, uint32_t pseudo_checksum )
+{
+  array<char, LENGTH> scratch {};
+  const string_view raw = parser.contiguous( scratch );
+  if ( parser.has_error() ) {
+    return;
+  }
+
+  WireHeader header {};
+  Layout::decode( header, raw );
+  if ( header.data_offset < LENGTH / 4 ) {
+    parser.set_error();
+    return;
+  }
+
+  options.resize( header.data_offset * size_t { 4 } - LENGTH );
+  parser.string( options );
+  if ( parser.has_error() ) {
+    return;
+  }
+
+  TCPSenderMessage& sender = message.sender;
+  parser.all_remaining( sender.payload );
+  InternetChecksum payload_sum;
+  payload_sum.add( sender.payload );
+  sender.payload_sum = payload_sum.sum();
+
+  // The sum over pseudo-header, header (checksum field included), options and payload must be all ones
+  InternetChecksum check { pseudo_checksum + *sender.payload_sum };
+  check.add( raw );
+  check.add( options );
+  if ( check.value() != 0 ) {
+    parser.set_error();
+    return;
+  }
+
+  src_port = header.src_port;
+  dst_port = header.dst_port;
+  RST = header.RST;
+  cksum = header.cksum;
+  sender.seqno = Wrap32 { header.seqno };
+  sender.SYN = header.SYN;
+  sender.FIN = header.FIN;
+  message.receiver.ackno = header.ACK ? optional { Wrap32 { header.ackno } } : nullopt;
+  message.receiver.window_size = header.window;
+}
+
+void TCPSegment::serialize( Serializer& serializer ) const
+{
+  check_options( options );
+  encode( *this, serializer.room( LENGTH ) );
+  if ( not options.empty() ) {
+    memcpy( serializer.room( options.size() ), options.data(), options.size() );
+  }
+  serializer.buffer( message.sender.payload );
+}
+
+IPv4Datagram TCPSegment::to_datagram( uint32_t src, uint32_t dst ) const
+{
+  IPv4Datagram datagram;
+  datagram.header.src = src;
+  datagram.header.dst = dst;
+  datagram.header.proto = IPv4Header::PROTO_TCP;
+  datagram.header.len = static_cast<uint16_t>( IPv4Header::LENGTH + serialized_length() );
+  datagram.header.compute_checksum();
+
+  TCPSegment segment = *this;
+  segment.compute_checksum( datagram.header.pseudo_checksum() );
+
+  // The headers are written on the stack and copied into one pooled Buffer; the payload is shared
+  array<char, LENGTH + MAX_OPTIONS> headroom {};
+  Serializer serializer { headroom };
+  segment.serialize( serializer );
+  datagram.payload = serializer.output();
+  return datagram;
+}
+
+bool TCPSegment::parse_datagram( const IPv4Datagram& datagram )
+{
+  if ( datagram.header.proto != IPv4Header::PROTO_TCP ) {
+    return false;
+  }
+  Parser parser { datagram.payload };
+  parse( parser, datagram.header.pseudo_checksum() );
+  return not parser.has_error();
+}
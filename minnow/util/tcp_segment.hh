@@ -0,0 +1,69 @@
+#pragma once
+
+#include "ipv4_datagram.hh"
+#include "parser.hh"
+#include "tcp_message.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// TCP segment: a TCPMessage, plus what only matters on the wire (ports, RST, options and the checksum)
+struct TCPSegment
+{
+  static constexpr size_t LENGTH = 20;      // TCP header length, not including options
+  static constexpr size_t MAX_OPTIONS = 40; // the data offset field allows at most this many bytes of options
+
+  /*
+   *   0                   1                   2                   3
+   *   0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
+   *  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+   *  |          Source Port          |       Destination Port        |
+   *  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+   *  |                        Sequence Number                        |
+   *  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+   *  |                    Acknowledgment Number                      |
+   *  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+   *  |  Data |       |C|E|U|A|P|R|S|F|                               |
+   *  | Offset| Rsrvd |W|C|R|C|S|S|Y|I|            Window             |
+   *  |       |       |R|E|G|K|H|T|N|N|                               |
+   *  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+   *  |           Checksum            |         Urgent Pointer        |
+   *  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+   *  |                    Options                    |    Padding    |
+   *  +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
+   *
+   * The seqno, SYN, FIN and payload come from message.sender; ACK, the ackno and the window from
+   * message.receiver. URG, PSH and the urgent pointer are sent as zero and ignored when parsing.
+   */
+
+  uint16_t src_port = 0;   // source port
+  uint16_t dst_port = 0;   // destination port
+  TCPMessage message {};   // sequence and acknowledgment state, flags and payload
+  bool RST = false;        // reset flag
+  uint16_t cksum = 0;      // checksum field
+  std::string options {};  // raw option bytes, a multiple of four long
+
+  // Length of the header, options included
+  size_t header_length() const { return LENGTH + options.size(); }
+
+  // Length of the whole segment
+  size_t serialized_length() const { return header_length() + message.sender.payload.size(); }
+
+  // Set checksum to correct value, given the pseudo-header's contribution (IPv4Header::pseudo_checksum()).
+  // Uses message.sender.payload_sum, when known, instead of reading the payload.
+  void compute_checksum( uint32_t pseudo_checksum );
+
+  // Parse a segment whose pseudo-header sums to `pseudo_checksum`; the checksum must verify. The payload
+  // shares the input's Buffers, and its sum is recorded in message.sender.payload_sum.
+  void parse( Parser& parser, uint32_t pseudo_checksum );
+
+  // Serialize the TCPSegment (does not recompute the checksum)
+  void serialize( Serializer& serializer ) const;
+
+  // An IPv4 datagram from `src` to `dst` carrying this segment, with both checksums computed
+  IPv4Datagram to_datagram( uint32_t src, uint32_t dst ) const;
+
+  // Parse the segment carried by `datagram`. Returns false if it does not carry a valid TCP segment.
+  bool parse_datagram( const IPv4Datagram& datagram );
+};
@@ -3,6 +3,8 @@
 #include "buffer.hh"
 #include "wrapping_integers.hh"
 
+#include <cstdint>
+#include <optional>
 #include <string>
 
 /*
@@ -19,6 +21,9 @@
  * 3) The payload: a substring (possibly empty) of the byte stream.
  *
  * 4) The FIN flag. If set, it means the payload represents the ending of the byte stream.
+ *
+ * The sender may also record the one's-complement sum of the payload, computed while copying it out
+ * of the stream, so that checksumming the segment later does not have to read the payload again.
  */
 
 struct TCPSenderMessage
@@ -27,6 +32,7 @@ struct TCPSenderMessage
   bool SYN { false };
   Buffer payload {};
   bool FIN { false };
+  std::optional<uint16_t> payload_sum {}; // InternetChecksum::sum() of the payload, if known
 
   // How many sequence numbers does this segment use?
   size_t sequence_length() const { return SYN + payload.size() + FIN; }
@@ -0,0 +1,235 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// A hierarchical timing wheel (Varghese & Lauck) keyed on a millisecond clock.
+//
+// Timers are created once and then armed, re-armed and cancelled in O(1). Advancing the clock
+// only visits timers that actually expire (plus an occasional cascade of a higher-level slot
+// into the levels below it), so a wheel holding many idle timers costs almost nothing per tick.
+// Each timer carries a `T` supplied at creation, which is handed back when it expires.
+template<typename T>
+class TimerWheel
+{
+public:
+  using TimerId = uint32_t;
+
+  static constexpr unsigned SLOT_BITS = 6;
+  static constexpr size_t SLOTS = size_t { 1 } << SLOT_BITS;
+  static constexpr size_t LEVELS = 4; // spans 2^24 ms (about 4.6 hours); later deadlines are re-filed
+
+private:
+  static constexpr uint32_t NIL = std::numeric_limits<uint32_t>::max();
+  static constexpr uint64_t SLOT_MASK = SLOTS - 1;
+
+  struct Node
+  {
+    T value {};
+    uint64_t deadline {};
+    uint32_t prev = NIL;
+    uint32_t next = NIL;
+    uint32_t bucket = NIL; // level * SLOTS + slot while armed, NIL otherwise
+    bool in_use {};
+  };
+
+  uint64_t now_ {};
+  size_t armed_ {};
+  std::vector<Node> nodes_ {};
+  std::vector<TimerId> free_ {};
+  std::array<uint32_t, LEVELS * SLOTS> heads_ {};
+  std::array<uint64_t, LEVELS> occupied_ {}; // bitmap of non-empty slots per level
+
+  Node& node( TimerId id )
+  {
+    if ( id >= nodes_.size() or not nodes_[id].in_use ) {
+      throw std::runtime_error( "TimerWheel: invalid timer id" );
+    }
+    return nodes_[id];
+  }
+
+  void link( TimerId id, uint64_t earliest )
+  {
+    Node& n = nodes_[id];
+    const uint64_t when = std::max( n.deadline, earliest );
+
+    // Pick the lowest level whose enclosing block also contains `now_`
+    size_t level = 0;
+    while ( level + 1 < LEVELS
+            and ( when >> ( SLOT_BITS * ( level + 1 ) ) ) != ( now_ >> ( SLOT_BITS * ( level + 1 ) ) ) ) {
+      level++;
+    }
+
+    uint64_t slot {};
+    if ( ( when >> ( SLOT_BITS * LEVELS ) ) != ( now_ >> ( SLOT_BITS * LEVELS ) ) ) {
+      // Beyond the top level's span: park in the next top-level slot, to be re-filed when it is reached
+      slot = ( ( now_ >> ( SLOT_BITS * level ) ) + 1 ) & SLOT_MASK;
+    } else {
+      slot = ( when >> ( SLOT_BITS * level ) ) & SLOT_MASK;
+    }
+
+    const uint32_t bucket = level * SLOTS + slot;
+    n.bucket = bucket;
+    n.prev = NIL;
+    n.next = heads_[bucket];
+    if ( n.next != NIL ) {
+      nodes_[n.next].prev = id;
+    }
+    heads_[bucket] = id;
+    occupied_[level] |= uint64_t { 1 } << slot;
+    armed_++;
+  }
+
+  void unlink( TimerId id )
+  {
+    Node& n = nodes_[id];
+    if ( n.prev != NIL ) {
+      nodes_[n.prev].next = n.next;
+    } else {
+      heads_[n.bucket] = n.next;
+      if ( n.next == NIL ) {
+        occupied_[n.bucket / SLOTS] &= ~( uint64_t { 1 } << ( n.bucket % SLOTS ) );
+      }
+    }
+    if ( n.next != NIL ) {
+      nodes_[n.next].prev = n.prev;
+    }
+    n.prev = n.next = n.bucket = NIL;
+    armed_--;
+  }
+
+  // Re-file every timer of a higher-level slot into the levels below it
+  void cascade( size_t level )
+  {
+    const uint32_t bucket = level * SLOTS + ( ( now_ >> ( SLOT_BITS * level ) ) & SLOT_MASK );
+    while ( heads_[bucket] != NIL ) {
+      const TimerId id = heads_[bucket];
+      unlink( id );
+      link( id, now_ );
+    }
+  }
+
+public:
+  TimerWheel() { heads_.fill( NIL ); }
+
+  // Current time of the wheel, in milliseconds since construction
+  uint64_t now() const { return now_; }
+
+  // Number of armed timers
+  size_t size() const { return armed_; }
+  bool empty() const { return armed_ == 0; }
+
+  // Allocate an (unarmed) timer carrying `value`
+  TimerId create( T value )
+  {
+    TimerId id {};
+    if ( free_.empty() ) {
+      id = static_cast<TimerId>( nodes_.size() );
+      nodes_.emplace_back();
+    } else {
+      id = free_.back();
+      free_.pop_back();
+    }
+    nodes_[id].value = std::move( value );
+    nodes_[id].in_use = true;
+    return id;
+  }
+
+  // Release a timer (cancelling it if armed); `id` may be reused by a later create()
+  void destroy( TimerId id )
+  {
+    cancel( id );
+    nodes_[id].in_use = false;
+    nodes_[id].value = T {};
+    free_.push_back( id );
+  }
+
+  // Arm (or re-arm) a timer to expire at absolute time `deadline`. Deadlines that are not in the
+  // future expire on the next call to advance().
+  void schedule( TimerId id, uint64_t deadline )
+  {
+    cancel( id );
+    node( id ).deadline = deadline;
+    link( id, now_ + 1 );
+  }
+
+  // Arm (or re-arm) a timer to expire `ms` from now
+  void schedule_in( TimerId id, uint64_t ms ) { schedule( id, now_ + ms ); }
+
+  // Disarm a timer; a no-op if it is not armed
+  void cancel( TimerId id )
+  {
+    if ( node( id ).bucket != NIL ) {
+      unlink( id );
+    }
+  }
+
+  // When to next call advance(): after now(), and no later than the earliest armed deadline (earlier, if that
+  // deadline is still filed in a coarse slot that must first be cascaded). Max if no timer is armed.
+  uint64_t next_expiry() const
+  {
+    for ( size_t level = 0; level < LEVELS; level++ ) {
+      if ( occupied_[level] == 0 ) {
+        continue;
+      }
+      // The first occupied slot after the current one, wrapping around
+      const unsigned shift = SLOT_BITS * level;
+      const uint64_t current = ( now_ >> shift ) & SLOT_MASK;
+      const uint64_t ahead = std::rotr( occupied_[level], static_cast<int>( ( current + 1 ) & SLOT_MASK ) );
+      return ( ( now_ >> shift ) + 1 + std::countr_zero( ahead ) ) << shift;
+    }
+    return std::numeric_limits<uint64_t>::max();
+  }
+
+  bool armed( TimerId id ) const { return id < nodes_.size() and nodes_[id].bucket != NIL; }
+  uint64_t deadline( TimerId id ) const { return nodes_.at( id ).deadline; }
+  T& value( TimerId id ) { return node( id ).value; }
+
+  // Move the clock forward by `ms`, calling `on_expire( id, value )` for every timer whose deadline
+  // has been reached. Expired timers are disarmed before the callback runs, which may re-arm,
+  // cancel or destroy any timer (including the expiring one).
+  template<typename F>
+  void advance( uint64_t ms, F&& on_expire )
+  {
+    const uint64_t target = now_ + ms;
+    while ( now_ < target ) {
+      if ( armed_ == 0 ) {
+        now_ = target;
+        break;
+      }
+
+      // Skip straight past stretches in which the lower levels hold nothing
+      uint64_t next = now_ + 1;
+      for ( size_t level = 0; level + 1 < LEVELS and occupied_[level] == 0; level++ ) {
+        const unsigned shift = SLOT_BITS * ( level + 1 );
+        next = ( ( now_ >> shift ) + 1 ) << shift;
+      }
+      if ( next > target ) {
+        now_ = target;
+        break;
+      }
+      now_ = next;
+
+      for ( size_t level = LEVELS - 1; level > 0; level-- ) {
+        if ( ( now_ & ( ( uint64_t { 1 } << ( SLOT_BITS * level ) ) - 1 ) ) == 0 ) {
+          cascade( level );
+        }
+      }
+
+      const uint32_t bucket = now_ & SLOT_MASK;
+      while ( heads_[bucket] != NIL ) {
+        const TimerId id = heads_[bucket];
+        unlink( id );
+        T value = nodes_[id].value; // the callback may create timers and reallocate nodes_
+        on_expire( id, value );
+      }
+    }
+  }
+};